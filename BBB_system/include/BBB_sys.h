@@ -27,24 +27,53 @@ namespace BBB_sys {
         public:
             BBB_i2c_oled(int bus);
 
+            BBB_i2c_oled(Transport& transport);
+
             ~BBB_i2c_oled();
 
             void init();
 
+            bool loadFont(const std::string& bdfPath, const std::string& cachePath);
+
+            const Font& getFont() const;
+
+            TextCacheStats getTextCacheStats() const;
+
             void textBox(const std::vector<std::string>& text, int x, int y);
 
             void textBox(const std::string& text, int x, int y);
 
+            bool image(const std::string& path, int x, int y);
+
             void progressBarHrz(int x1, int y1, int x2, int y2, int color, int min, int max, int value);
 
             void progressBarVrt(int x1, int y1, int x2, int y2, int color, int min, int max, int value);
 
+            void updateText(const std::string& text, int x, int y);
+
+            void updateTextBox(const std::vector<std::string>& text, int x, int y);
+
+            void updateTextBox(const std::string& text, int x, int y);
+
+            void updateProgressBarHrz(int x1, int y1, int x2, int y2, int color, int min, int max, int value);
+
+            void updateProgressBarVrt(int x1, int y1, int x2, int y2, int color, int min, int max, int value);
+
             void updateScreen();
 
             SSD1306* getDisplay();
             
         private:
+            int lookupLines(const std::vector<std::string>& text);
+
+            void drawTextBox(const std::vector<std::string>& text, int maxLineWidth, int x, int y);
+
+            void drawTextBox(const TextRun& line, int x, int y);
+
             SSD1306 display;
+            std::unique_ptr<Font> font;     // Text box font, the built-in 6x8 one until loadFont()
+            TextCache textCache;            // Rendered text box lines
+            std::vector<const TextRun*> lines;  // Runs of the box being drawn, null for lines drawn uncached
     };
 
     class Menu {
@@ -74,6 +103,7 @@ namespace BBB_sys {
     class System {
         public:
             System(int i2c_bus);
+            System(Transport& transport);
             ~System();
 
             void init_frame();
@@ -84,6 +114,10 @@ namespace BBB_sys {
 
             void updateState();
 
+            void updateClock();
+
+            void updateGauge();
+
             void checkMessages();
 
             void emptyMessages();
@@ -8,12 +8,19 @@
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <linux/i2c-dev.h>
+#include "SSD1306_transport.h"
+#include "SSD1306_canvas.h"
 #include <cstring>
 #include <string>
 #include <bitset>
 #include <thread>
 #include <chrono>
 #include <cmath>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
 
 #define I2C_SLAVE_ADDR 0x3C
 
@@ -26,7 +33,9 @@
 #define SET_CHARGE_PUMP 0x8D
 #define SET_MEM_ADD_MODE 0x20
 #define SET_SEG_REMAP 0xA1
+#define SET_SEG_NO_REMAP 0xA0
 #define SET_COM_OUTPUT_SC_DIR 0xC8
+#define SET_COM_OUTPUT_NORMAL 0xC0
 #define SET_COM_PINS 0xDA
 #define SET_DISP_CONTRAST 0x81
 #define SET_PRE_CH_PRD 0xD9
@@ -38,23 +47,63 @@
 
 // Display configuration parameters
 #define DISPCLK_DIV 0x80
-#define MULTIPLEX_64 0x3F
 #define DISP_OFFSET 0x00
 #define ENABLE_CH_PUMP 0x14
 #define HOR_MEM_ADD_MODE 0x00
-#define CONFIG_COM_PINS 0x12
 #define CONTRAST_LEVEL 0xCF
 #define CONFIG_PRE_CH_PRD 0xF1
 #define PX_TURNOFF_V 0x40
-#define BLACK 0
-#define WHITE 1
 
-class SSD1306 {
+// Pages of the controller GRAM, the start line wraps around all of them
+#define GRAM_PAGES 8
+#define GRAM_COLUMNS 128
+
+// Cost of one windowed transaction in bus bytes (window commands + control bytes)
+#define WINDOW_OVERHEAD 9
+
+// Retry interval while the display does not answer, doubled after every failed probe
+#define RECOVERY_BACKOFF_MIN_MS 20
+#define RECOVERY_BACKOFF_MAX_MS 2000
+
+// Frame counters of the background flush thread and bus error recovery
+struct SSD1306Stats {
+    uint64_t framesPresented;     // Frames handed over with present()
+    uint64_t framesFlushed;       // Frames sent by the flush thread
+    uint64_t framesDropped;       // Presented frames replaced before they were sent
+    uint64_t busErrors;           // Failed batches
+    uint64_t offlineSkips;        // Renders and commands dropped while waiting to retry
+    uint64_t probes;              // Attempts to reach the display while offline
+    uint64_t recoveries;          // Times the display came back and was re-initialized
+};
+
+// Orientations the controller does by itself: the segment remap mirrors the
+// columns and the COM scan direction the rows, both cost nothing per frame
+enum Orientation {
+    ORIENT_NORMAL = 0,
+    ORIENT_MIRROR_X = 1,
+    ORIENT_MIRROR_Y = 2,
+    ORIENT_ROTATE_180 = ORIENT_MIRROR_X | ORIENT_MIRROR_Y
+};
+
+// SSD1306 driver, the Layout policy (ColumnMajor or PageMajor) selects how
+// the frame buffers are stored and carries the panel geometry, so buffer
+// sizes, the init sequence and clipping are all fixed at compile time. All
+// drawing goes to the Canvas returned by getCanvas(), the driver only sends
+// canvases to the display. A QuarterTurn layout draws in portrait and is
+// turned to the panel while flushing, see PanelMap.
+template<class Layout>
+class SSD1306Driver {
     public:
 
-        SSD1306(const int bus);
+        static const int WIDTH = Layout::WIDTH;
+        static const int HEIGHT = Layout::HEIGHT;
+        static const int PAGES = Layout::PAGES;
+
+        SSD1306Driver(const int bus);
+
+        SSD1306Driver(Transport& transport);
 
-        ~SSD1306();
+        ~SSD1306Driver();
 
         bool begin();
 
@@ -72,35 +121,23 @@ class SSD1306 {
 
         int sendCommand(const uint8_t *commands, size_t len);
 
-        void inverseDisplay(bool is_inverse);
-
-        void drawText(const std::string& text, int x, int y);
-
-        void drawChar(char c, int x, int y);
+        void queueCommand(const uint8_t *commands, size_t len);
 
-        void draw_8(uint8_t* bitmap, size_t width, int x, int y);
+        int flushCommands();
 
-        void drawPixel(int x, int y, int color);
-
-        void drawLine(int x0, int y0, int x1, int y1, int width, int color);
+        void inverseDisplay(bool is_inverse);
 
-        void drawHrzLine(int x0, int x1, int y, int color);
+        void setOrientation(Orientation orientation);
 
-        void drawVertLine(int y0, int y1, int x, int color);
+        Orientation getOrientation();
 
-        void drawRectangle(int x0, int y0, int x1, int y1, int color);
+        Canvas<Layout>& getCanvas();
 
-        void fillRectangle(int x0, int y0, int x1, int y1, int color);
+        int addSprite(const Bitmap& bitmap, RasterOp op);
 
-        void drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, int width, int color);
+        void moveSprite(int id, int x, int y);
 
-        void drawEqTriangle(int tipX, int tipY, int height, int width, int color);
-
-        void drawCircle(int center_x, int center_y, int radius, int color);
-        
-        void fillCircle(int center_x, int center_y, int radius, int color);
-        
-        void draw_64(uint64_t* bitmap);
+        void hideSprite(int id);
 
         void startHorizontalScroll(int startPage, int endPage, int direction, int speed);
 
@@ -111,15 +148,121 @@ class SSD1306 {
 
         void stopScroll();
 
+        void consoleLine(const std::string& text);
+
         void renderDisplay(int startPage, int endPage);
 
-        uint8_t* ASCIImap(char c);
+        void renderFrame();
+
+        void renderWindow(int col0, int col1, int page0, int page1);
+
+        void updateRegion(int x0, int y0, int x1, int y1);
+
+        void present();
+
+        void startFlushThread();
+
+        void stopFlushThread();
+
+        bool isFlushThreadRunning() const;
+
+        bool isOnline();
+
+        SSD1306Stats getStats();
+
+        void invalidateDisplay();
+
+        const Layout& getFrame() const;
 
     private:
-        const int bus;                // The i2c bus number
-        int file;               // File descriptor for i2c communication
+        typedef Canvas<Layout> FrameSlot;
+        typedef PanelMap<Layout> Map;
+        typedef typename Map::Panel Panel;
+        typedef PageMajor<Panel::WIDTH, Panel::HEIGHT> Shadow;
+
+        uint8_t segRemap() const;
+
+        uint8_t comScanDir() const;
+
+        int columnOffset() const;
+
+        void forgetSprites();
+
+        void swapBack(bool keepFrame);
+
+        void presentRegion(int x0, int y0, int x1, int y1);
+
+        void queueWindow(FrameSlot* slot, int col0, int col1, int page0, int page1);
+
+        void restorePatches();
+
+        bool flushWindows();
+
+        bool writeWindow(FrameSlot* slot, int col0, int col1, int page0, int page1);
+
+        bool queueSlot(FrameSlot* slot, int startPage, int endPage);
+
+        void renderSlot(FrameSlot* slot, int startPage, int endPage);
+
+        int flushTransport();
+
+        bool sendInit();
+
+        bool busReady();
+
+        void busFailed(int error);
+
+        void flushLoop();
+
+        const int bus;                // The i2c bus number, -1 for an external transport
+        std::unique_ptr<Transport> ownedTransport;  // Transport created from the bus number
+        Transport* transport;         // Batched transport to the display
         uint8_t cursor[3];            // Page cursor
-        uint64_t frameBuffer[128];    // Buffer for current display frame
+        std::vector<Sprite> sprites;  // Sprites registered with addSprite(), drawn into the back buffer
+        FrameSlot frames[3];          // Back, pending and front canvases
+        FrameSlot* back;              // Frame the drawing functions write to
+        FrameSlot* pending;           // Latest presented frame waiting for the flush thread
+        FrameSlot* front;             // Frame the flush thread is sending
+        Shadow shadow;                // Copy of the panel pages last sent to the display GRAM
+        uint8_t shadowPages;          // One bit per panel page whose GRAM content is known
+        int scrollPage;               // GRAM page shown at the top, logical page p is stored in GRAM page (p + scrollPage) % 8
+        Orientation orientation;      // Segment remap and COM scan direction, guarded by busMutex
+
+        // Bytes borrowed for control bytes by zero-copy windows of the current batch
+        struct Patch {
+            uint8_t* at;
+            uint8_t saved;
+        };
+        Patch patches[Panel::PAGES];
+        int patchCount;
+
+        // Bus error recovery, guarded by busMutex
+        bool online;                  // Last transfer succeeded
+        int lastError;                // errno of the last failed transfer
+        int backoffMs;                // Current retry interval
+        std::chrono::steady_clock::time_point retryAt;    // Next probe while offline
+
+        std::mutex busMutex;          // Serializes transport and shadow access
+        std::mutex frameMutex;        // Guards pending and the flush thread state
+        std::condition_variable frameReady;
+        std::thread flushThread;
+        bool flushRunning;            // Flush thread is alive
+        bool pendingReady;            // pending holds a frame not yet taken by the flush thread
+        SSD1306Stats stats;
 };
 
+// Panel of the default driver, build with e.g. -DSSD1306_HEIGHT=32 for a 128x32 module
+#ifndef SSD1306_WIDTH
+#define SSD1306_WIDTH 128
+#endif
+#ifndef SSD1306_HEIGHT
+#define SSD1306_HEIGHT 64
+#endif
+
+// The default column-major driver
+typedef SSD1306Driver<ColumnMajor<SSD1306_WIDTH, SSD1306_HEIGHT>> SSD1306;
+
+// Offscreen canvas that blits onto the default driver's frames
+typedef Canvas<ColumnMajor<SSD1306_WIDTH, SSD1306_HEIGHT>> SSD1306Canvas;
+
 #endif // SSD1306_H
@@ -0,0 +1,53 @@
+// SSD1306_bitmap.h header file
+
+#ifndef SSD1306_BITMAP_H
+#define SSD1306_BITMAP_H
+
+#include <iostream>
+#include <cstdint>
+#include <vector>
+
+// How blitted bitmap pixels combine with the frame
+enum RasterOp {
+    ROP_COPY,       // Bitmap replaces the frame, clear bits erase
+    ROP_OR,         // Set bits are drawn
+    ROP_AND_NOT,    // Set bits are erased
+    ROP_XOR         // Set bits are toggled
+};
+
+// 1-bit image of up to 64 rows stored like the column-major frame buffer,
+// bit y of column x is pixel (x, y), so a blit is one shifted mask per column
+class Bitmap {
+    public:
+
+        Bitmap(int width, int height);
+
+        Bitmap(const uint8_t* columns, int width);
+
+        Bitmap(const uint64_t* columns, int width, int height);
+
+        int getWidth() const;
+
+        int getHeight() const;
+
+        uint64_t rowsMask() const;
+
+        uint64_t column(int x) const;
+
+        const uint64_t* data() const;
+
+        void setColumn(int x, uint64_t rows);
+
+        void setPixel(int x, int y, bool is_on);
+
+        bool getPixel(int x, int y) const;
+
+        void clear();
+
+    private:
+        int width;
+        int height;
+        std::vector<uint64_t> columns;
+};
+
+#endif // SSD1306_BITMAP_H
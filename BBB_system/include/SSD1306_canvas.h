@@ -0,0 +1,189 @@
+// SSD1306_canvas.h header file
+
+#ifndef SSD1306_CANVAS_H
+#define SSD1306_CANVAS_H
+
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include "SSD1306_layout.h"
+#include "SSD1306_bitmap.h"
+#include "SSD1306_sprite.h"
+#include "SSD1306_pnm.h"
+#include "SSD1306_font.h"
+#include "SSD1306_textcache.h"
+
+#define BLACK 0
+#define WHITE 1
+
+template<class Layout> class SSD1306Driver;
+
+// Vertex of a polyline or polygon
+struct Point {
+    int x;
+    int y;
+};
+
+// Monochrome drawing surface with the panel geometry of its Layout. The
+// driver flushes its canvases to the display, any number of others can be
+// drawn offscreen and blitted onto them. Drawing records a dirty column span
+// per page so a flush only looks at what changed.
+//
+// Coordinates are relative to the current viewport and everything outside
+// the current clip rectangle is left untouched. Both come from a stack, a
+// widget pushes its area, draws at (0, 0) and pops it again. Clipping is
+// applied to whole column spans, not pixel by pixel.
+template<class Layout>
+class Canvas {
+    public:
+
+        static const int WIDTH = Layout::WIDTH;
+        static const int HEIGHT = Layout::HEIGHT;
+        static const int PAGES = Layout::PAGES;
+
+        Canvas();
+
+        void clear();
+
+        const Layout& getBuffer() const;
+
+        void markDirty(int x0, int x1, uint64_t rows);
+
+        void clearDirty();
+
+        void scrollUp();
+
+        void pushClip(int x0, int y0, int x1, int y1);
+
+        void pushViewport(int x, int y, int width, int height);
+
+        void popClip();
+
+        void drawText(const std::string& text, int x, int y, RasterOp op = ROP_OR);
+
+        void drawText(const Font& font, const std::string& text, int x, int y, RasterOp op = ROP_OR);
+
+        void drawText(TextCache& cache, const Font& font, const std::string& text, int x, int y, RasterOp op = ROP_OR);
+
+        void drawRun(const TextRun& run, int x, int y, RasterOp op = ROP_OR);
+
+        void draw_8(const uint8_t* bitmap, size_t width, int x, int y);
+
+        void drawPixel(int x, int y, int color);
+
+        void drawLine(int x0, int y0, int x1, int y1, int width, int color);
+
+        void drawHrzLine(int x0, int x1, int y, int color);
+
+        void drawVertLine(int y0, int y1, int x, int color);
+
+        void drawRectangle(int x0, int y0, int x1, int y1, int color);
+
+        void fillRectangle(int x0, int y0, int x1, int y1, int color);
+
+        void drawPolyline(const std::vector<Point>& points, int width, int color);
+
+        void drawPolygon(const std::vector<Point>& points, int width, int color);
+
+        void fillPolygon(const std::vector<Point>& points, int color);
+
+        void drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, int width, int color);
+
+        void fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, int color);
+
+        void drawEqTriangle(int tipX, int tipY, int height, int width, int color);
+
+        void drawCircle(int center_x, int center_y, int radius, int color);
+
+        void fillCircle(int center_x, int center_y, int radius, int color);
+
+        void drawArc(int center_x, int center_y, int radius, int startAngle, int endAngle, int width, int color);
+
+        void drawRoundRect(int x0, int y0, int x1, int y1, int radius, int color);
+
+        void fillRoundRect(int x0, int y0, int x1, int y1, int radius, int color);
+
+        void draw_64(uint64_t* bitmap);
+
+        void blit(const Bitmap& bitmap, int x, int y, RasterOp op);
+
+        void blitColumns(const uint64_t* columns, int width, int height, int x, int y, RasterOp op);
+
+        void drawImage(const PnmImage& image, int x, int y, DitherMode mode = DITHER_BAYER);
+
+        // Copies the source rectangle (sx, sy, width, height) of another canvas to (x, y)
+        template<class Source>
+        void blit(const Canvas<Source>& source, int sx, int sy, int width, int height, int x, int y, RasterOp op) {
+
+            // Clip the rectangle to the source, at most 64 rows go through one column word
+            if(sx < 0) { width += sx; x -= sx; sx = 0; }
+            if(sy < 0) { height += sy; y -= sy; sy = 0; }
+            width = std::min(width, Source::WIDTH - sx);
+            height = std::min(std::min(height, Source::HEIGHT - sy), 64);
+
+            if(width <= 0 || height <= 0) {
+                return;
+            }
+
+            uint64_t columns[Source::WIDTH];
+            for(int col = 0; col < width; col++) {
+                columns[col] = source.getBuffer().column(sx + col) >> sy;
+            }
+            blitColumns(columns, width, height, x, y, op);
+        }
+
+        void moveSprite(Sprite& sprite, int x, int y);
+
+        void hideSprite(Sprite& sprite);
+
+        static const uint8_t* ASCIImap(char c);
+
+    private:
+        template<class> friend class SSD1306Driver;
+
+        uint64_t spanMask(int y0, int y1) const;
+
+        void fillColumns(int x0, int x1, uint64_t rows, int color);
+
+        void fillConvex(const Point* points, int count, int color);
+
+        void traceEdge(int x0, int y0, int x1, int y1, int first, int last, int* top, int* bottom) const;
+
+        void fillTraced(const int* top, const int* bottom, int first, int last, int color);
+
+        void applyColumns(const uint64_t* masks, int first, int last, int color);
+
+        static uint64_t panelRows(int y0, int y1);
+
+        static int sineQ10(int degrees);
+
+        static void traceDisc(int center_x, int center_y, int radius, int first, int last, int* top, int* bottom);
+
+        static void traceCircle(int center_x, int center_y, int radius, int quadrants, int first, int last, uint64_t* masks);
+
+        void drawJoins(const std::vector<Point>& points, bool closed, int width, int color);
+
+        void drawSprite(Sprite& sprite, bool erase);
+
+        // Origin and clip rectangle in canvas coordinates
+        struct View {
+            int x, y;
+            int x0, y0, x1, y1;
+        };
+
+        void pushView(int x, int y, int x0, int y0, int x1, int y1);
+
+        void setView(const View& view);
+
+        Layout buffer;
+        int dirtyStart[PAGES];    // First changed column on each page
+        int dirtyEnd[PAGES];      // Last changed column on each page, < dirtyStart when clean
+        View view;                // Current origin and clip rectangle
+        uint64_t clipRows;        // Rows mask of the clip rectangle
+        std::vector<View> views;  // Views saved by the pushes
+};
+
+#endif // SSD1306_CANVAS_H
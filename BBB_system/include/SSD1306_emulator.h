@@ -0,0 +1,99 @@
+// SSD1306_emulator.h header file
+
+#ifndef SSD1306_EMULATOR_H
+#define SSD1306_EMULATOR_H
+
+#include "SSD1306_transport.h"
+
+#define EMU_COLUMNS 128
+#define EMU_PAGES 8
+#define EMU_ROWS 64
+
+// Addressing modes selected with SET_MEM_ADD_MODE
+#define EMU_HOR_ADDRESSING 0
+#define EMU_VER_ADDRESSING 1
+#define EMU_PAGE_ADDRESSING 2
+
+// In-process SSD1306 controller. Decodes the command and data stream the
+// driver produces into a simulated 128x64 GRAM so flush paths can be
+// benchmarked and verified without a display on the bus.
+class SSD1306Emulator : public Transport {
+    public:
+
+        SSD1306Emulator();
+
+        ~SSD1306Emulator();
+
+        bool open() override;
+
+        void close() override;
+
+        bool isOpen() const override;
+
+        void powerOn();
+
+        void setConnected(bool is_connected);
+
+        bool gramPixel(int col, int row) const;
+
+        bool displayPixel(int x, int y) const;
+
+        void readDisplay(uint64_t* columns) const;
+
+        const uint8_t* getGram() const;
+
+        uint64_t getCommandBytes() const;
+
+        uint64_t getDataBytes() const;
+
+        int getStartLine() const;
+
+        int getContrast() const;
+
+        bool isInverse() const;
+
+        bool isDisplayOn() const;
+
+        bool isScrolling() const;
+
+        int getAddressingMode() const;
+
+    protected:
+        int submit(const std::vector<Message>& messages) override;
+
+    private:
+        void commandByte(uint8_t byte);
+
+        void executeCommand();
+
+        void dataByte(uint8_t byte);
+
+        bool opened;
+        bool connected;                 // Display answers on the bus
+        uint8_t gram[EMU_PAGES][EMU_COLUMNS];   // Simulated graphic display data RAM
+
+        uint8_t command[8];             // Command currently being decoded
+        int commandLen;                 // Bytes of the command received so far
+        int commandArgs;                // Argument bytes the command expects
+
+        int addressingMode;
+        int colStart, colEnd;           // Column address window
+        int pageStart, pageEnd;         // Page address window
+        int col, page;                  // GRAM pointer
+
+        int startLine;
+        int displayOffset;
+        int multiplex;
+        int contrast;
+        bool inverse;
+        bool displayOn;
+        bool entireOn;
+        bool segRemap;
+        bool comReverse;
+        bool scrolling;
+
+        uint64_t commandBytes;
+        uint64_t dataBytes;
+};
+
+#endif // SSD1306_EMULATOR_H
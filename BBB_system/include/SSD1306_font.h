@@ -0,0 +1,541 @@
+// SSD1306_font.h header file
+
+#ifndef SSD1306_FONT_H
+#define SSD1306_FONT_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstdint>
+#include <cerrno>
+#include <cctype>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+
+// Column bytes of one glyph, bit 0 is the top row
+typedef uint8_t Glyph[8];
+
+// Code point of malformed UTF-8, drawn with each font's replacement glyph
+#define UTF8_REPLACEMENT 0xFFFD
+
+uint32_t decodeUTF8(const std::string& text, size_t& i);
+
+// Next code point of UTF-8 text from byte i on, i is moved past it. ASCII
+// is one compare, multibyte sequences are decoded by decodeUTF8().
+inline uint32_t nextCodePoint(const std::string& text, size_t& i) {
+
+    const unsigned char byte = text[i];
+    if(byte < 0x80) {
+        i++;
+        return byte;
+    }
+    return decodeUTF8(text, i);
+}
+
+// The built-in 6x8 font, every 8 bit character code in code page 437 order:
+// printable ASCII, accented letters, box drawing, arrows and symbols. A
+// glyph is 5 columns and a blank one, the last two bytes are padding so a
+// glyph is one aligned 8 byte load. The table is constexpr and lives in
+// .rodata, glyph() is a bounds-safe index into it.
+//
+// Text is UTF-8 and unicode() finds the glyph of a code point: Latin-1 has
+// a glyph for every code point, in the table or among the extra glyphs,
+// and the other code page 437 symbols are found in a sorted table. Code
+// points without a glyph show the REPLACEMENT block.
+struct Font6x8 {
+    static const int ADVANCE = 6;
+    static const int HEIGHT = 8;
+    static const int GLYPHS = 256;
+    static const int FALLBACK = '?';      // Shown for codes outside the table
+    static const int EXTRA_GLYPHS = 42;
+    static const int REPLACEMENT = 0xFE;  // Shown for code points without a glyph
+    static const int SYMBOLS = 114;
+
+    alignas(8) static constexpr Glyph glyphs[GLYPHS] = {
+        // 0x00 Control codes: faces, card suits, arrows and other symbols
+        {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+        {0x38,0x74,0x5c,0x74,0x38,0x00,0x00,0x00},
+        {0x38,0x74,0x7c,0x74,0x38,0x00,0x00,0x00},
+        {0x18,0x3c,0x78,0x3c,0x18,0x00,0x00,0x00},
+        {0x10,0x38,0x7c,0x38,0x10,0x00,0x00,0x00},
+        {0x18,0x14,0x7c,0x14,0x18,0x00,0x00,0x00},
+        {0x30,0x18,0x7c,0x18,0x30,0x00,0x00,0x00},
+        {0x00,0x10,0x38,0x10,0x00,0x00,0x00,0x00},
+        {0xfe,0xee,0xc6,0xee,0xfe,0x00,0x00,0x00},
+        {0x00,0x10,0x28,0x10,0x00,0x00,0x00,0x00},
+        {0xfe,0xee,0xc6,0xee,0xfe,0x00,0x00,0x00},
+        {0x20,0x50,0x34,0x0c,0x1c,0x00,0x00,0x00},
+        {0x00,0x28,0x74,0x28,0x00,0x00,0x00,0x00},
+        {0x60,0x38,0x04,0x08,0x00,0x00,0x00,0x00},
+        {0x60,0x38,0x04,0x34,0x1c,0x00,0x00,0x00},
+        {0x00,0x10,0x28,0x10,0x00,0x00,0x00,0x00},
+        {0x00,0x7c,0x38,0x10,0x00,0x00,0x00,0x00},
+        {0x00,0x10,0x38,0x7c,0x00,0x00,0x00,0x00},
+        {0x00,0x28,0x7c,0x28,0x00,0x00,0x00,0x00},
+        {0x00,0x5c,0x00,0x5c,0x00,0x00,0x00,0x00},
+        {0x18,0xfc,0x04,0xfc,0x04,0x00,0x00,0x00},
+        {0x90,0xa8,0x48,0x54,0x24,0x00,0x00,0x00},
+        {0x60,0x60,0x60,0x60,0x60,0x00,0x00,0x00},
+        {0x00,0xa8,0xfc,0xa8,0x00,0x00,0x00,0x00},
+        {0x00,0x08,0x7c,0x08,0x00,0x00,0x00,0x00},
+        {0x00,0x20,0x7c,0x20,0x00,0x00,0x00,0x00},
+        {0x10,0x10,0x10,0x38,0x10,0x00,0x00,0x00},
+        {0x10,0x38,0x10,0x10,0x10,0x00,0x00,0x00},
+        {0x30,0x20,0x20,0x20,0x20,0x00,0x00,0x00},
+        {0x10,0x38,0x10,0x38,0x10,0x00,0x00,0x00},
+        {0x40,0x60,0x70,0x60,0x40,0x00,0x00,0x00},
+        {0x10,0x30,0x70,0x30,0x10,0x00,0x00,0x00},
+
+        // 0x20 Printable ASCII
+        {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0x5c,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x0c,0x00,0x0c,0x00,0x00,0x00,0x00},
+        {0x28,0x7c,0x28,0x7c,0x28,0x00,0x00,0x00},
+        {0x00,0x50,0xec,0x28,0x00,0x00,0x00,0x00},
+        {0x44,0x2a,0x34,0x58,0x24,0x00,0x00,0x00},
+        {0x20,0x58,0x54,0x24,0x50,0x00,0x00,0x00},
+        {0x00,0x00,0x06,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x38,0x44,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x44,0x38,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x54,0x38,0x54,0x00,0x00,0x00,0x00},
+        {0x00,0x10,0x38,0x10,0x00,0x00,0x00,0x00},
+        {0x00,0x80,0x40,0x00,0x00,0x00,0x00,0x00},
+        {0x08,0x08,0x08,0x08,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0x40,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x60,0x18,0x04,0x00,0x00,0x00,0x00},
+        {0x38,0x44,0x44,0x38,0x00,0x00,0x00,0x00},
+        {0x00,0x08,0x7c,0x00,0x00,0x00,0x00,0x00},
+        {0x48,0x64,0x54,0x48,0x00,0x00,0x00,0x00},
+        {0x44,0x54,0x54,0x28,0x00,0x00,0x00,0x00},
+        {0x20,0x30,0x28,0x7c,0x00,0x00,0x00,0x00},
+        {0x5c,0x54,0x54,0x24,0x00,0x00,0x00,0x00},
+        {0x38,0x54,0x54,0x20,0x00,0x00,0x00,0x00},
+        {0x04,0x64,0x14,0x0c,0x00,0x00,0x00,0x00},
+        {0x28,0x54,0x54,0x28,0x00,0x00,0x00,0x00},
+        {0x08,0x54,0x54,0x38,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0x50,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x80,0x50,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x10,0x28,0x44,0x00,0x00,0x00,0x00},
+        {0x00,0x28,0x28,0x28,0x00,0x00,0x00,0x00},
+        {0x00,0x44,0x28,0x10,0x00,0x00,0x00,0x00},
+        {0x00,0x54,0x14,0x08,0x00,0x00,0x00,0x00},
+        {0x38,0x44,0x54,0x54,0x08,0x00,0x00,0x00},
+        {0x78,0x14,0x14,0x78,0x00,0x00,0x00,0x00},
+        {0x7c,0x54,0x54,0x28,0x00,0x00,0x00,0x00},
+        {0x38,0x44,0x44,0x44,0x00,0x00,0x00,0x00},
+        {0x7c,0x44,0x44,0x38,0x00,0x00,0x00,0x00},
+        {0x7c,0x54,0x54,0x44,0x00,0x00,0x00,0x00},
+        {0x7c,0x14,0x14,0x04,0x00,0x00,0x00,0x00},
+        {0x38,0x44,0x44,0x68,0x00,0x00,0x00,0x00},
+        {0x7c,0x10,0x10,0x7c,0x00,0x00,0x00,0x00},
+        {0x00,0x44,0x7c,0x44,0x00,0x00,0x00,0x00},
+        {0x30,0x40,0x40,0x3c,0x00,0x00,0x00,0x00},
+        {0x7c,0x10,0x28,0x44,0x00,0x00,0x00,0x00},
+        {0x7c,0x40,0x40,0x40,0x00,0x00,0x00,0x00},
+        {0x7c,0x10,0x10,0x7c,0x00,0x00,0x00,0x00},
+        {0x7c,0x08,0x10,0x7c,0x00,0x00,0x00,0x00},
+        {0x38,0x44,0x44,0x38,0x00,0x00,0x00,0x00},
+        {0x7c,0x14,0x14,0x08,0x00,0x00,0x00,0x00},
+        {0x38,0x44,0x44,0xb8,0x00,0x00,0x00,0x00},
+        {0x7c,0x14,0x14,0x68,0x00,0x00,0x00,0x00},
+        {0x48,0x54,0x54,0x24,0x00,0x00,0x00,0x00},
+        {0x04,0x04,0x7c,0x04,0x04,0x00,0x00,0x00},
+        {0x3c,0x40,0x40,0x3c,0x00,0x00,0x00,0x00},
+        {0x1c,0x60,0x60,0x1c,0x00,0x00,0x00,0x00},
+        {0x1c,0x60,0x18,0x60,0x1c,0x00,0x00,0x00},
+        {0x4c,0x30,0x10,0x6c,0x00,0x00,0x00,0x00},
+        {0x00,0x1c,0x60,0x1c,0x00,0x00,0x00,0x00},
+        {0x64,0x54,0x4c,0x44,0x00,0x00,0x00,0x00},
+        {0x00,0x7c,0x44,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x0c,0x30,0x40,0x00,0x00,0x00,0x00},
+        {0x00,0x44,0x7c,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x08,0x04,0x08,0x00,0x00,0x00,0x00},
+        {0x80,0x80,0x80,0x80,0x80,0x00,0x00,0x00},
+        {0x00,0x04,0x08,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x68,0x28,0x70,0x00,0x00,0x00,0x00},
+        {0x7e,0x48,0x48,0x30,0x00,0x00,0x00,0x00},
+        {0x00,0x30,0x48,0x48,0x00,0x00,0x00,0x00},
+        {0x30,0x48,0x48,0x7c,0x00,0x00,0x00,0x00},
+        {0x30,0x58,0x58,0x50,0x00,0x00,0x00,0x00},
+        {0x10,0x78,0x14,0x04,0x00,0x00,0x00,0x00},
+        {0x10,0xa8,0xa8,0x78,0x00,0x00,0x00,0x00},
+        {0x7c,0x08,0x08,0x70,0x00,0x00,0x00,0x00},
+        {0x00,0x48,0x7a,0x40,0x00,0x00,0x00,0x00},
+        {0x00,0x80,0x80,0x7a,0x00,0x00,0x00,0x00},
+        {0x7c,0x10,0x28,0x40,0x00,0x00,0x00,0x00},
+        {0x00,0x42,0x7e,0x40,0x00,0x00,0x00,0x00},
+        {0x78,0x10,0x10,0x78,0x00,0x00,0x00,0x00},
+        {0x78,0x08,0x08,0x70,0x00,0x00,0x00,0x00},
+        {0x30,0x48,0x48,0x30,0x00,0x00,0x00,0x00},
+        {0xf8,0x48,0x48,0x30,0x00,0x00,0x00,0x00},
+        {0x30,0x48,0x48,0xf8,0x00,0x00,0x00,0x00},
+        {0x00,0x78,0x10,0x08,0x00,0x00,0x00,0x00},
+        {0x50,0x58,0x68,0x28,0x00,0x00,0x00,0x00},
+        {0x08,0x3c,0x48,0x48,0x00,0x00,0x00,0x00},
+        {0x38,0x40,0x40,0x78,0x00,0x00,0x00,0x00},
+        {0x18,0x60,0x60,0x18,0x00,0x00,0x00,0x00},
+        {0x78,0x20,0x20,0x78,0x00,0x00,0x00,0x00},
+        {0x48,0x30,0x30,0x48,0x00,0x00,0x00,0x00},
+        {0x18,0xa0,0xa0,0x78,0x00,0x00,0x00,0x00},
+        {0x48,0x68,0x58,0x48,0x00,0x00,0x00,0x00},
+        {0x00,0x18,0x24,0x42,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0x7e,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x42,0x24,0x18,0x00,0x00,0x00,0x00},
+        {0x10,0x08,0x10,0x08,0x00,0x00,0x00,0x00},
+        {0x60,0x50,0x48,0x50,0x60,0x00,0x00,0x00},
+
+        // 0x80 Accented Latin letters, currency and punctuation
+        {0x38,0x44,0xc4,0x44,0x00,0x00,0x00,0x00},
+        {0x38,0x42,0x40,0x7a,0x00,0x00,0x00,0x00},
+        {0x30,0x58,0x5a,0x51,0x00,0x00,0x00,0x00},
+        {0x28,0x4a,0x31,0x42,0x00,0x00,0x00,0x00},
+        {0x48,0x2a,0x70,0x42,0x00,0x00,0x00,0x00},
+        {0x48,0x29,0x72,0x40,0x00,0x00,0x00,0x00},
+        {0x48,0x28,0x72,0x40,0x00,0x00,0x00,0x00},
+        {0x00,0x30,0xc8,0x48,0x00,0x00,0x00,0x00},
+        {0x30,0x5a,0x59,0x52,0x00,0x00,0x00,0x00},
+        {0x30,0x5a,0x58,0x52,0x00,0x00,0x00,0x00},
+        {0x30,0x59,0x5a,0x50,0x00,0x00,0x00,0x00},
+        {0x00,0x4a,0x78,0x42,0x00,0x00,0x00,0x00},
+        {0x00,0x4a,0x79,0x42,0x00,0x00,0x00,0x00},
+        {0x00,0x49,0x7a,0x40,0x00,0x00,0x00,0x00},
+        {0x79,0x14,0x15,0x78,0x00,0x00,0x00,0x00},
+        {0x78,0x14,0x15,0x78,0x00,0x00,0x00,0x00},
+        {0x7c,0x54,0x56,0x45,0x00,0x00,0x00,0x00},
+        {0x68,0x38,0x70,0x58,0x58,0x00,0x00,0x00},
+        {0x78,0x14,0x7c,0x54,0x00,0x00,0x00,0x00},
+        {0x30,0x4a,0x49,0x32,0x00,0x00,0x00,0x00},
+        {0x30,0x4a,0x48,0x32,0x00,0x00,0x00,0x00},
+        {0x30,0x49,0x4a,0x30,0x00,0x00,0x00,0x00},
+        {0x38,0x42,0x41,0x7a,0x00,0x00,0x00,0x00},
+        {0x38,0x41,0x42,0x78,0x00,0x00,0x00,0x00},
+        {0x18,0xa2,0xa0,0x7a,0x00,0x00,0x00,0x00},
+        {0x39,0x44,0x44,0x39,0x00,0x00,0x00,0x00},
+        {0x3c,0x41,0x40,0x3d,0x00,0x00,0x00,0x00},
+        {0x30,0x48,0xcc,0x48,0x00,0x00,0x00,0x00},
+        {0x50,0x7c,0x52,0x46,0x00,0x00,0x00,0x00},
+        {0x02,0x2e,0x70,0x2e,0x02,0x00,0x00,0x00},
+        {0x7e,0x12,0x1c,0x38,0x50,0x00,0x00,0x00},
+        {0x90,0x7c,0x12,0x12,0x00,0x00,0x00,0x00},
+        {0x48,0x2a,0x71,0x40,0x00,0x00,0x00,0x00},
+        {0x00,0x48,0x7a,0x41,0x00,0x00,0x00,0x00},
+        {0x30,0x48,0x4a,0x31,0x00,0x00,0x00,0x00},
+        {0x38,0x40,0x42,0x79,0x00,0x00,0x00,0x00},
+        {0x7a,0x09,0x0a,0x71,0x00,0x00,0x00,0x00},
+        {0x7e,0x19,0x22,0x7d,0x00,0x00,0x00,0x00},
+        {0x00,0x24,0x2a,0x2c,0x00,0x00,0x00,0x00},
+        {0x00,0x24,0x2a,0x24,0x00,0x00,0x00,0x00},
+        {0x20,0x50,0x4a,0x20,0x00,0x00,0x00,0x00},
+        {0x60,0x20,0x20,0x20,0x20,0x00,0x00,0x00},
+        {0x20,0x20,0x20,0x20,0x60,0x00,0x00,0x00},
+        {0x2e,0x10,0x48,0x54,0x70,0x00,0x00,0x00},
+        {0x2e,0x10,0x48,0x64,0xf2,0x00,0x00,0x00},
+        {0x00,0x20,0x7a,0x20,0x00,0x00,0x00,0x00},
+        {0x20,0x50,0x20,0x50,0x00,0x00,0x00,0x00},
+        {0x50,0x20,0x50,0x20,0x00,0x00,0x00,0x00},
+
+        // 0xB0 Shades, box drawing and blocks
+        {0x55,0xaa,0x55,0xaa,0x55,0x00,0x00,0x00},
+        {0x55,0xbb,0x55,0xee,0x55,0x00,0x00,0x00},
+        {0x55,0xff,0xaa,0xff,0x55,0x00,0x00,0x00},
+        {0x00,0x00,0xff,0x00,0x00,0x00,0x00,0x00},
+        {0x08,0x08,0xff,0x00,0x00,0x00,0x00,0x00},
+        {0x14,0x14,0xff,0x00,0x00,0x00,0x00,0x00},
+        {0x08,0xff,0x00,0xff,0x00,0x00,0x00,0x00},
+        {0x08,0xf8,0x08,0xf8,0x00,0x00,0x00,0x00},
+        {0x14,0x14,0xfc,0x00,0x00,0x00,0x00,0x00},
+        {0x14,0xf7,0x00,0xff,0x00,0x00,0x00,0x00},
+        {0x00,0xff,0x00,0xff,0x00,0x00,0x00,0x00},
+        {0x14,0xf4,0x04,0xfc,0x00,0x00,0x00,0x00},
+        {0x14,0x17,0x10,0x1f,0x00,0x00,0x00,0x00},
+        {0x08,0x0f,0x08,0x0f,0x00,0x00,0x00,0x00},
+        {0x14,0x14,0x1f,0x00,0x00,0x00,0x00,0x00},
+        {0x08,0x08,0xf8,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0x0f,0x08,0x08,0x00,0x00,0x00},
+        {0x08,0x08,0x0f,0x08,0x08,0x00,0x00,0x00},
+        {0x08,0x08,0xf8,0x08,0x08,0x00,0x00,0x00},
+        {0x00,0x00,0xff,0x08,0x08,0x00,0x00,0x00},
+        {0x08,0x08,0x08,0x08,0x08,0x00,0x00,0x00},
+        {0x08,0x08,0xff,0x08,0x08,0x00,0x00,0x00},
+        {0x00,0x00,0xff,0x14,0x14,0x00,0x00,0x00},
+        {0x00,0xff,0x00,0xff,0x08,0x00,0x00,0x00},
+        {0x00,0x1f,0x10,0x17,0x14,0x00,0x00,0x00},
+        {0x00,0xfc,0x04,0xf4,0x14,0x00,0x00,0x00},
+        {0x14,0x17,0x10,0x17,0x14,0x00,0x00,0x00},
+        {0x14,0xf4,0x04,0xf4,0x14,0x00,0x00,0x00},
+        {0x00,0xff,0x00,0xf7,0x14,0x00,0x00,0x00},
+        {0x14,0x14,0x14,0x14,0x14,0x00,0x00,0x00},
+        {0x14,0xf7,0x00,0xf7,0x14,0x00,0x00,0x00},
+        {0x14,0x14,0x17,0x14,0x14,0x00,0x00,0x00},
+        {0x08,0x0f,0x08,0x0f,0x08,0x00,0x00,0x00},
+        {0x14,0x14,0xf4,0x14,0x14,0x00,0x00,0x00},
+        {0x08,0xf8,0x08,0xf8,0x08,0x00,0x00,0x00},
+        {0x00,0x0f,0x08,0x0f,0x08,0x00,0x00,0x00},
+        {0x00,0x00,0x1f,0x14,0x14,0x00,0x00,0x00},
+        {0x00,0x00,0xfc,0x14,0x14,0x00,0x00,0x00},
+        {0x00,0xf8,0x08,0xf8,0x08,0x00,0x00,0x00},
+        {0x08,0xff,0x08,0xff,0x08,0x00,0x00,0x00},
+        {0x14,0x14,0xff,0x14,0x14,0x00,0x00,0x00},
+        {0x08,0x08,0x0f,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0xf8,0x08,0x08,0x00,0x00,0x00},
+        {0xff,0xff,0xff,0xff,0xff,0x00,0x00,0x00},
+        {0xf0,0xf0,0xf0,0xf0,0xf0,0x00,0x00,0x00},
+        {0xff,0xff,0xff,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0x00,0xff,0xff,0x00,0x00,0x00},
+        {0x0f,0x0f,0x0f,0x0f,0x0f,0x00,0x00,0x00},
+
+        // 0xE0 Greek letters and math symbols
+        {0x30,0x48,0x48,0x30,0x48,0x00,0x00,0x00},
+        {0xfc,0x4a,0x4a,0x3c,0x00,0x00,0x00,0x00},
+        {0x00,0x7e,0x02,0x02,0x00,0x00,0x00,0x00},
+        {0x00,0x7c,0x04,0x7c,0x00,0x00,0x00,0x00},
+        {0x62,0x56,0x4a,0x42,0x66,0x00,0x00,0x00},
+        {0x38,0x44,0x44,0x3c,0x04,0x00,0x00,0x00},
+        {0xf8,0x40,0x40,0x38,0x40,0x00,0x00,0x00},
+        {0x02,0x04,0x78,0x06,0x02,0x00,0x00,0x00},
+        {0x10,0x28,0xee,0x28,0x10,0x00,0x00,0x00},
+        {0x38,0x54,0x54,0x54,0x38,0x00,0x00,0x00},
+        {0x58,0x64,0x04,0x64,0x58,0x00,0x00,0x00},
+        {0x32,0x4d,0x49,0x30,0x00,0x00,0x00,0x00},
+        {0x30,0x48,0x78,0x48,0x30,0x00,0x00,0x00},
+        {0x50,0x28,0x58,0x48,0x34,0x00,0x00,0x00},
+        {0x00,0x3c,0x4a,0x4a,0x00,0x00,0x00,0x00},
+        {0x7c,0x02,0x02,0x7c,0x00,0x00,0x00,0x00},
+        {0x54,0x54,0x54,0x54,0x00,0x00,0x00,0x00},
+        {0x48,0x48,0x5c,0x48,0x48,0x00,0x00,0x00},
+        {0x40,0x62,0x54,0x48,0x00,0x00,0x00,0x00},
+        {0x00,0x48,0x54,0x62,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0xf8,0x04,0x0c,0x00,0x00,0x00},
+        {0x30,0x20,0x1f,0x00,0x00,0x00,0x00,0x00},
+        {0x10,0x54,0x54,0x10,0x00,0x00,0x00,0x00},
+        {0x48,0x24,0x48,0x24,0x00,0x00,0x00,0x00},
+        {0x00,0x08,0x14,0x08,0x00,0x00,0x00,0x00},
+        {0x00,0x18,0x18,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0x08,0x00,0x00,0x00,0x00,0x00},
+        {0x20,0x40,0x30,0x0c,0x04,0x00,0x00,0x00},
+        {0x00,0x0e,0x02,0x0c,0x00,0x00,0x00,0x00},
+        {0x00,0x12,0x1a,0x14,0x00,0x00,0x00,0x00},
+        {0x00,0x38,0x38,0x38,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00}
+    };
+
+    // Latin-1 letters and signs code page 437 does not have, then the
+    // ellipsis and the euro sign. Glyph numbers GLYPHS and up are these.
+    alignas(8) static constexpr Glyph extraGlyphs[EXTRA_GLYPHS] = {
+        {0x44,0x38,0x28,0x38,0x44,0x00,0x00,0x00},
+        {0x00,0x00,0x6c,0x00,0x00,0x00,0x00,0x00},
+        {0x00,0x02,0x00,0x02,0x00,0x00,0x00,0x00},
+        {0x3c,0x42,0x5a,0x66,0x3c,0x00,0x00,0x00},
+        {0x3c,0x42,0x7e,0x56,0x2c,0x00,0x00,0x00},
+        {0x01,0x01,0x01,0x01,0x00,0x00,0x00,0x00},
+        {0x00,0x11,0x15,0x1f,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0x02,0x01,0x00,0x00,0x00,0x00},
+        {0x00,0x00,0x80,0xc0,0x00,0x00,0x00,0x00},
+        {0x00,0x12,0x1f,0x10,0x00,0x00,0x00,0x00},
+        {0x2a,0x14,0x48,0x64,0xf2,0x00,0x00,0x00},
+        {0x78,0x15,0x16,0x78,0x00,0x00,0x00,0x00},
+        {0x78,0x14,0x16,0x79,0x00,0x00,0x00,0x00},
+        {0x78,0x16,0x15,0x7a,0x00,0x00,0x00,0x00},
+        {0x7a,0x15,0x16,0x79,0x00,0x00,0x00,0x00},
+        {0x7c,0x55,0x56,0x44,0x00,0x00,0x00,0x00},
+        {0x7c,0x56,0x55,0x46,0x00,0x00,0x00,0x00},
+        {0x7d,0x54,0x54,0x45,0x00,0x00,0x00,0x00},
+        {0x00,0x44,0x7d,0x46,0x00,0x00,0x00,0x00},
+        {0x00,0x44,0x7c,0x46,0x01,0x00,0x00,0x00},
+        {0x00,0x44,0x7e,0x45,0x02,0x00,0x00,0x00},
+        {0x00,0x45,0x7c,0x45,0x00,0x00,0x00,0x00},
+        {0x10,0x7c,0x54,0x44,0x38,0x00,0x00,0x00},
+        {0x38,0x45,0x46,0x38,0x00,0x00,0x00,0x00},
+        {0x38,0x44,0x46,0x39,0x00,0x00,0x00,0x00},
+        {0x38,0x46,0x45,0x3a,0x00,0x00,0x00,0x00},
+        {0x3a,0x45,0x46,0x39,0x00,0x00,0x00,0x00},
+        {0x00,0x28,0x10,0x28,0x00,0x00,0x00,0x00},
+        {0x78,0x64,0x54,0x3c,0x00,0x00,0x00,0x00},
+        {0x3c,0x41,0x42,0x3c,0x00,0x00,0x00,0x00},
+        {0x3c,0x40,0x42,0x3d,0x00,0x00,0x00,0x00},
+        {0x3c,0x42,0x41,0x3e,0x00,0x00,0x00,0x00},
+        {0x00,0x1c,0x60,0x1e,0x01,0x00,0x00,0x00},
+        {0x7c,0x28,0x28,0x10,0x00,0x00,0x00,0x00},
+        {0x02,0x69,0x2a,0x71,0x00,0x00,0x00,0x00},
+        {0x30,0x4a,0x4e,0x34,0x00,0x00,0x00,0x00},
+        {0x32,0x49,0x4a,0x31,0x00,0x00,0x00,0x00},
+        {0x70,0x68,0x58,0x38,0x00,0x00,0x00,0x00},
+        {0x18,0xa0,0xa2,0x79,0x00,0x00,0x00,0x00},
+        {0xfe,0x48,0x48,0x30,0x00,0x00,0x00,0x00},
+        {0x40,0x00,0x40,0x00,0x40,0x00,0x00,0x00},
+        {0x10,0x38,0x54,0x54,0x44,0x00,0x00,0x00}
+    };
+
+    // Glyph number of every code point from U+00A0 to U+00FF
+    static constexpr uint16_t latin1[96] = {
+        0x20, 0xAD, 0x9B, 0x9C, GLYPHS + 0, 0x9D, GLYPHS + 1, 0x15,
+        GLYPHS + 2, GLYPHS + 3, 0xA6, 0xAE, 0xAA, 0x2D, GLYPHS + 4, GLYPHS + 5,
+        0xF8, 0xF1, 0xFD, GLYPHS + 6, GLYPHS + 7, 0xE6, 0x14, 0xFA,
+        GLYPHS + 8, GLYPHS + 9, 0xA7, 0xAF, 0xAC, 0xAB, GLYPHS + 10, 0xA8,
+        GLYPHS + 11, GLYPHS + 12, GLYPHS + 13, GLYPHS + 14, 0x8E, 0x8F, 0x92, 0x80,
+        GLYPHS + 15, 0x90, GLYPHS + 16, GLYPHS + 17, GLYPHS + 18, GLYPHS + 19, GLYPHS + 20, GLYPHS + 21,
+        GLYPHS + 22, 0xA5, GLYPHS + 23, GLYPHS + 24, GLYPHS + 25, GLYPHS + 26, 0x99, GLYPHS + 27,
+        GLYPHS + 28, GLYPHS + 29, GLYPHS + 30, GLYPHS + 31, 0x9A, GLYPHS + 32, GLYPHS + 33, 0xE1,
+        0x85, 0xA0, 0x83, GLYPHS + 34, 0x84, 0x86, 0x91, 0x87,
+        0x8A, 0x82, 0x88, 0x89, 0x8D, 0xA1, 0x8C, 0x8B,
+        GLYPHS + 35, 0xA4, 0x95, 0xA2, 0x93, GLYPHS + 36, 0x94, 0xF6,
+        GLYPHS + 37, 0x97, 0xA3, 0x96, 0x81, GLYPHS + 38, GLYPHS + 39, 0x98
+    };
+
+    // Glyph numbers of other code points, sorted: Greek letters, punctuation,
+    // arrows, math, box drawing and the code page 437 symbols
+    struct Symbol {
+        uint16_t code;
+        uint16_t glyph;
+    };
+
+    static constexpr Symbol symbols[SYMBOLS] = {
+        {0x0192, 0x9F}, {0x0393, 0xE2}, {0x0398, 0xE9}, {0x03A3, 0xE4}, {0x03A6, 0xE8}, {0x03A9, 0xEA},
+        {0x03B1, 0xE0}, {0x03B4, 0xEB}, {0x03B5, 0xEE}, {0x03C0, 0xE3}, {0x03C3, 0xE5}, {0x03C4, 0xE7},
+        {0x03C6, 0xED}, {0x2013, '-'}, {0x2014, '-'}, {0x2018, '\''}, {0x2019, '\''}, {0x201C, '"'},
+        {0x201D, '"'}, {0x2022, 0x07}, {0x2026, GLYPHS + 40}, {0x203C, 0x13}, {0x207F, 0xFC}, {0x20A7, 0x9E},
+        {0x20AC, GLYPHS + 41}, {0x2190, 0x1B}, {0x2191, 0x18}, {0x2192, 0x1A}, {0x2193, 0x19}, {0x2194, 0x1D},
+        {0x2195, 0x12}, {0x21A8, 0x17}, {0x2212, '-'}, {0x2219, 0xF9}, {0x221A, 0xFB}, {0x221E, 0xEC},
+        {0x221F, 0x1C}, {0x2229, 0xEF}, {0x2248, 0xF7}, {0x2261, 0xF0}, {0x2264, 0xF3}, {0x2265, 0xF2},
+        {0x2302, 0x7F}, {0x2310, 0xA9}, {0x2320, 0xF4}, {0x2321, 0xF5}, {0x2500, 0xC4}, {0x2502, 0xB3},
+        {0x250C, 0xDA}, {0x2510, 0xBF}, {0x2514, 0xC0}, {0x2518, 0xD9}, {0x251C, 0xC3}, {0x2524, 0xB4},
+        {0x252C, 0xC2}, {0x2534, 0xC1}, {0x253C, 0xC5}, {0x2550, 0xCD}, {0x2551, 0xBA}, {0x2552, 0xD5},
+        {0x2553, 0xD6}, {0x2554, 0xC9}, {0x2555, 0xB8}, {0x2556, 0xB7}, {0x2557, 0xBB}, {0x2558, 0xD4},
+        {0x2559, 0xD3}, {0x255A, 0xC8}, {0x255B, 0xBE}, {0x255C, 0xBD}, {0x255D, 0xBC}, {0x255E, 0xC6},
+        {0x255F, 0xC7}, {0x2560, 0xCC}, {0x2561, 0xB5}, {0x2562, 0xB6}, {0x2563, 0xB9}, {0x2564, 0xD1},
+        {0x2565, 0xD2}, {0x2566, 0xCB}, {0x2567, 0xCF}, {0x2568, 0xD0}, {0x2569, 0xCA}, {0x256A, 0xD8},
+        {0x256B, 0xD7}, {0x256C, 0xCE}, {0x2580, 0xDF}, {0x2584, 0xDC}, {0x2588, 0xDB}, {0x258C, 0xDD},
+        {0x2590, 0xDE}, {0x2591, 0xB0}, {0x2592, 0xB1}, {0x2593, 0xB2}, {0x25A0, 0xFE}, {0x25AC, 0x16},
+        {0x25B2, 0x1E}, {0x25BA, 0x10}, {0x25BC, 0x1F}, {0x25C4, 0x11}, {0x25CB, 0x09}, {0x25D8, 0x08},
+        {0x25D9, 0x0A}, {0x263A, 0x01}, {0x263B, 0x02}, {0x263C, 0x0F}, {0x2640, 0x0C}, {0x2642, 0x0B},
+        {0x2660, 0x06}, {0x2663, 0x05}, {0x2665, 0x03}, {0x2666, 0x04}, {0x266A, 0x0D}, {0x266B, 0x0E}
+    };
+
+    static constexpr const Glyph& glyph(unsigned char c) {
+        return glyphs[c];
+    }
+
+    static constexpr const Glyph& glyph(char c) {
+        return glyphs[static_cast<unsigned char>(c)];
+    }
+
+    static constexpr const Glyph& glyph(int code) {
+        return glyphs[(code >= 0 && code < GLYPHS) ? code : FALLBACK];
+    }
+
+    // Glyph of a Unicode code point, ASCII indexes the table directly and
+    // anything else goes through number()
+    static const Glyph& unicode(uint32_t code) {
+        return (code < 0x80) ? glyphs[code] : numbered(number(code));
+    }
+
+    static const Glyph& numbered(int number) {
+        return (number < GLYPHS) ? glyphs[number] : extraGlyphs[number - GLYPHS];
+    }
+
+    static int number(uint32_t code);
+
+    static int measure(const std::string& text);
+};
+
+// Glyph of a Font, its bitmap is width column words of the font atlas from
+// offset onwards, bit 0 being the top row of the line
+struct FontGlyph {
+    uint32_t code;      // Unicode code point
+    uint32_t offset;    // First column in the atlas
+    int8_t left;        // Columns from the pen position to the first column
+    uint8_t width;      // Columns in the atlas, blank ones at the sides are dropped
+    uint8_t advance;    // Pen movement to the next glyph
+    uint8_t spare;
+};
+
+// Pen adjustment between two glyphs, negative pulls the right one closer
+struct FontKerning {
+    uint32_t left;
+    uint32_t right;
+    int32_t offset;
+};
+
+// Proportional 1-bit font of up to 64 rows with optional kerning pairs. The
+// glyph columns are packed into one atlas of column words, so drawing a
+// glyph is a shifted mask per column like any bitmap. Fonts come from BDF
+// files, which are slow to parse, so the parsed font can be kept in a cache
+// file laid out like the tables in memory and mapped as is on the next boot.
+// Text is measured with the same advances and kerning it is drawn with.
+class Font {
+    public:
+
+        Font();
+
+        Font(const std::string& bdfPath, const std::string& cachePath = "");
+
+        ~Font();
+
+        Font(const Font&) = delete;
+
+        Font& operator=(const Font&) = delete;
+
+        bool isValid() const;
+
+        int getHeight() const;
+
+        int getAscent() const;
+
+        uint32_t getRevision() const;
+
+        const FontGlyph& glyph(uint32_t code) const;
+
+        const uint64_t* columns(const FontGlyph& glyph) const;
+
+        int kerning(uint32_t left, uint32_t right) const;
+
+        void setKerning(uint32_t left, uint32_t right, int offset);
+
+        int measure(const std::string& text) const;
+
+        size_t fit(const std::string& text, int width) const;
+
+        bool saveCache(const std::string& path) const;
+
+    private:
+        bool loadBDF(const std::string& path);
+
+        bool mapCache(const std::string& path);
+
+        void addGlyph(uint32_t code, const uint64_t* columns, int width, int left, int advance);
+
+        void finish();
+
+        void own();
+
+        static uint32_t nextRevision();
+
+        int height;
+        int ascent;
+        uint32_t revision;                  // Changes with the glyphs or the kerning, unique across fonts
+        uint32_t fallback;                  // Code shown for code points the font does not have
+        int16_t ascii[128];                 // Glyph index of every ASCII code, -1 for none
+
+        const FontGlyph* glyphs;            // Sorted by code, owned or in the mapped cache
+        size_t glyphCount;
+        const FontKerning* kernings;        // Sorted by pair
+        size_t kerningCount;
+        const uint64_t* atlas;
+        size_t atlasColumns;
+
+        std::vector<FontGlyph> ownGlyphs;
+        std::vector<FontKerning> ownKernings;
+        std::vector<uint64_t> ownAtlas;
+        void* mapped;                       // Cache file mapping, nullptr when the tables are owned
+        size_t mappedSize;
+};
+
+#endif // SSD1306_FONT_H
@@ -0,0 +1,52 @@
+// SSD1306_image.h header file
+
+#ifndef SSD1306_IMAGE_H
+#define SSD1306_IMAGE_H
+
+#include <iostream>
+#include <cstdint>
+#include <vector>
+#include "SSD1306_bitmap.h"
+
+// How gray levels are turned into on and off pixels
+enum DitherMode {
+    DITHER_THRESHOLD,           // On above mid gray, for line art
+    DITHER_BAYER,               // 8x8 ordered pattern, stable between frames
+    DITHER_FLOYD_STEINBERG      // Error diffusion, finer detail for still images
+};
+
+// 8-bit grayscale image with 0 as black and 255 as white, rows stored top
+// to bottom. Images from files or cameras are scaled down to the panel and
+// dithered into a Bitmap, which a Canvas blits like any other.
+class GrayImage {
+    public:
+
+        GrayImage(int width, int height);
+
+        GrayImage(const uint8_t* pixels, int width, int height, int stride);
+
+        int getWidth() const;
+
+        int getHeight() const;
+
+        uint8_t* row(int y);
+
+        const uint8_t* row(int y) const;
+
+        GrayImage scaled(int width, int height) const;
+
+        Bitmap dither(DitherMode mode) const;
+
+        Bitmap toBitmap(int width, int height, DitherMode mode) const;
+
+    private:
+        Bitmap ditherThreshold(const uint8_t thresholds[8][8]) const;
+
+        Bitmap ditherFloydSteinberg() const;
+
+        int width;
+        int height;
+        std::vector<uint8_t> pixels;
+};
+
+#endif // SSD1306_IMAGE_H
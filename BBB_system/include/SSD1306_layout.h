@@ -0,0 +1,326 @@
+// SSD1306_layout.h header file
+
+#ifndef SSD1306_LAYOUT_H
+#define SSD1306_LAYOUT_H
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+// Panel geometry known at compile time. The SSD1306 GRAM is always 128x64,
+// smaller panels use part of it: MULTIPLEX and COM_PINS go into the init
+// sequence and COLUMN_OFFSET is the first GRAM column wired to the panel.
+template<int Width, int Height>
+struct SSD1306Geometry {
+    static_assert(Width > 0 && Width <= 128, "SSD1306 panels are at most 128 columns wide");
+    static_assert(Height <= 64, "SSD1306 frames are at most 64 rows, a 128x64 panel can't be mounted in portrait as a 64x128 QuarterTurn frame");
+    static_assert(Height >= 8 && Height % 8 == 0, "SSD1306 panel height has to be a multiple of 8");
+
+    static const int WIDTH = Width;
+    static const int HEIGHT = Height;
+    static const int PAGES = Height / 8;
+    static const uint8_t MULTIPLEX = Height - 1;
+    static const uint8_t COM_PINS = (Height > 32) ? 0x12 : 0x02;
+    static const uint8_t COLUMN_OFFSET = (Width == 64) ? 32 : 0;     // 64x48 modules use the middle of the GRAM
+};
+
+// Smallest unsigned word that holds one column of Height pixels
+template<int Height> struct ColumnWord { typedef uint64_t type; };
+template<> struct ColumnWord<8> { typedef uint8_t type; };
+template<> struct ColumnWord<16> { typedef uint16_t type; };
+template<> struct ColumnWord<24> { typedef uint32_t type; };
+template<> struct ColumnWord<32> { typedef uint32_t type; };
+
+// Frame buffer layouts for SSD1306Driver. Both store a Width x Height frame
+// with one bit per pixel and expose the same operations, so the driver and
+// the drawing functions compile against either one. Row masks are passed as
+// uint64_t whatever the panel height, bits past the last row are ignored.
+//
+//  - setPixel / clearPixel           single pixel
+//  - orColumn / andNotColumn / xorColumn   rows mask applied to one column
+//  - column                          all rows of a column as a uint64_t
+//  - pageByte / setPageByte          8 rows of a column as in the GRAM
+//  - pageMessage                     page data in place, for zero-copy flushes
+
+// Column-major: one word per column, bit y of word x is pixel (x, y).
+// Vertical spans are a single mask operation, a flush has to gather every
+// page byte with a shift.
+template<int Width, int Height>
+class ColumnMajor : public SSD1306Geometry<Width, Height> {
+    public:
+
+        typedef SSD1306Geometry<Width, Height> Geometry;
+        typedef typename ColumnWord<Height>::type Word;
+        using Geometry::WIDTH;
+        using Geometry::HEIGHT;
+        using Geometry::PAGES;
+        static const bool ZERO_COPY = false;
+
+        void clear() {
+            std::memset(this->columns, 0x00, sizeof(this->columns));
+        }
+
+        void setPixel(int x, int y) {
+            this->columns[x] |= static_cast<Word>(1ULL << y);
+        }
+
+        void clearPixel(int x, int y) {
+            this->columns[x] &= static_cast<Word>(~(1ULL << y));
+        }
+
+        bool getPixel(int x, int y) const {
+            return (this->columns[x] >> y) & 1;
+        }
+
+        uint64_t column(int x) const {
+            return this->columns[x];
+        }
+
+        void setColumn(int x, uint64_t rows) {
+            this->columns[x] = static_cast<Word>(rows);
+        }
+
+        void orColumn(int x, uint64_t mask) {
+            this->columns[x] |= static_cast<Word>(mask);
+        }
+
+        void andNotColumn(int x, uint64_t mask) {
+            this->columns[x] &= static_cast<Word>(~mask);
+        }
+
+        void xorColumn(int x, uint64_t mask) {
+            this->columns[x] ^= static_cast<Word>(mask);
+        }
+
+        uint8_t pageByte(int page, int x) const {
+            return (this->columns[x] >> (page*8)) & 0xFF;
+        }
+
+        void setPageByte(int page, int x, uint8_t bits) {
+            const int shift = page * 8;
+            this->columns[x] = static_cast<Word>((this->columns[x] & ~(0xFFULL << shift)) | (static_cast<uint64_t>(bits) << shift));
+        }
+
+        // Page data is not stored contiguously, the driver gathers it with pageByte()
+        uint8_t* pageMessage(int /* page */, int /* x */) {
+            return nullptr;
+        }
+
+    private:
+        Word columns[Width];
+};
+
+// Page-major: the GRAM layout, one byte per column and page. Every page row
+// is preceded by a spare byte so a page window is sent straight from the
+// buffer with the data control byte written in front of it.
+template<int Width, int Height>
+class PageMajor : public SSD1306Geometry<Width, Height> {
+    public:
+
+        typedef SSD1306Geometry<Width, Height> Geometry;
+        using Geometry::WIDTH;
+        using Geometry::HEIGHT;
+        using Geometry::PAGES;
+        static const bool ZERO_COPY = true;
+
+        void clear() {
+            std::memset(this->rows, 0x00, sizeof(this->rows));
+        }
+
+        void setPixel(int x, int y) {
+            this->rows[y >> 3][x + 1] |= 1 << (y & 7);
+        }
+
+        void clearPixel(int x, int y) {
+            this->rows[y >> 3][x + 1] &= ~(1 << (y & 7));
+        }
+
+        bool getPixel(int x, int y) const {
+            return (this->rows[y >> 3][x + 1] >> (y & 7)) & 1;
+        }
+
+        uint64_t column(int x) const {
+            uint64_t rows = 0;
+            for(int page = 0; page < PAGES; page++) {
+                rows |= static_cast<uint64_t>(this->rows[page][x + 1]) << (page*8);
+            }
+            return rows;
+        }
+
+        void setColumn(int x, uint64_t rows) {
+            for(int page = 0; page < PAGES; page++) {
+                this->rows[page][x + 1] = (rows >> (page*8)) & 0xFF;
+            }
+        }
+
+        void orColumn(int x, uint64_t mask) {
+            for(int page = 0; page < PAGES; page++) {
+                this->rows[page][x + 1] |= (mask >> (page*8)) & 0xFF;
+            }
+        }
+
+        void andNotColumn(int x, uint64_t mask) {
+            for(int page = 0; page < PAGES; page++) {
+                this->rows[page][x + 1] &= ~((mask >> (page*8)) & 0xFF);
+            }
+        }
+
+        void xorColumn(int x, uint64_t mask) {
+            for(int page = 0; page < PAGES; page++) {
+                this->rows[page][x + 1] ^= (mask >> (page*8)) & 0xFF;
+            }
+        }
+
+        uint8_t pageByte(int page, int x) const {
+            return this->rows[page][x + 1];
+        }
+
+        void setPageByte(int page, int x, uint8_t bits) {
+            this->rows[page][x + 1] = bits;
+        }
+
+        // Returns the byte in front of column x on the page, the page data
+        // from column x onwards follows it
+        uint8_t* pageMessage(int page, int x) {
+            return &this->rows[page][x];
+        }
+
+    private:
+        uint8_t rows[Height / 8][Width + 1];
+};
+
+// Transposes an 8x8 bit matrix stored one row per byte, bit j of byte i ends
+// up as bit i of byte j. Each of the three delta swaps exchanges the
+// off-diagonal quarters of every 2x2, 4x4 and then the 8x8 block in one go.
+inline uint64_t transpose8x8(uint64_t m) {
+    uint64_t t;
+    t = (m ^ (m >> 7)) & 0x00AA00AA00AA00AAULL;
+    m ^= t ^ (t << 7);
+    t = (m ^ (m >> 14)) & 0x0000CCCC0000CCCCULL;
+    m ^= t ^ (t << 14);
+    t = (m ^ (m >> 28)) & 0x00000000F0F0F0F0ULL;
+    m ^= t ^ (t << 28);
+    return m;
+}
+
+// Frame drawn in portrait on a panel mounted a quarter turn from its native
+// landscape orientation. Drawing sees a Frame of Width x Height, the top of
+// the frame runs down the right edge of the panel, which is Height columns
+// wide and Width rows tall. Every Canvas primitive works on one 64 row mask
+// per column, so only panels up to 64 columns wide turn: the 64x48 module
+// does, a 64x128 frame for the 128x64 panel fails a static_assert. The
+// driver builds the panel page bytes while flushing, an 8x8 block at a time
+// with transpose8x8(), so drawing pays nothing for the rotation. The other
+// quarter turn is this one plus ORIENT_ROTATE_180.
+template<class Frame>
+class QuarterTurn : public Frame {
+    public:
+
+        static const bool ZERO_COPY = false;
+};
+
+// How the driver sends a layout's frame to the panel. Frames are stored the
+// way the panel shows them except for QuarterTurn, the driver only sees
+// panel pages and columns through these functions.
+//
+//  - pixel                           panel pixel, for checking what is shown
+//  - pageByte / pageRow              panel page bytes of one or more columns
+//  - spans                           frame dirty spans as panel page spans
+//  - rect                            frame rectangle as the panel rectangle
+template<class Layout>
+struct PanelMap {
+    typedef SSD1306Geometry<Layout::WIDTH, Layout::HEIGHT> Panel;
+    static const bool TRANSPOSED = false;
+
+    static bool pixel(const Layout& frame, int x, int y) {
+        return frame.getPixel(x, y);
+    }
+
+    static uint8_t pageByte(const Layout& frame, int page, int x) {
+        return frame.pageByte(page, x);
+    }
+
+    static void pageRow(const Layout& frame, int page, int col0, int col1, uint8_t* out) {
+        for(int col = col0; col <= col1; col++) {
+            *out++ = frame.pageByte(page, col);
+        }
+    }
+
+    static void spans(const int* start, const int* end, int* panelStart, int* panelEnd) {
+        for(int page = 0; page < Panel::PAGES; page++) {
+            panelStart[page] = start[page];
+            panelEnd[page] = end[page];
+        }
+    }
+
+    static void rect(int& /* x0 */, int& /* y0 */, int& /* x1 */, int& /* y1 */) {
+    }
+};
+
+// Panel pixel (x, y) shows frame pixel (y, Panel::WIDTH - 1 - x), so a panel
+// page is 8 frame columns and its columns run up the frame rows
+template<class Frame>
+struct PanelMap<QuarterTurn<Frame>> {
+    typedef SSD1306Geometry<Frame::HEIGHT, Frame::WIDTH> Panel;
+    static const bool TRANSPOSED = true;
+
+    static bool pixel(const Frame& frame, int x, int y) {
+        return frame.getPixel(y, Panel::WIDTH - 1 - x);
+    }
+
+    // Frame page framePage of the 8 frame columns in panel page panelPage,
+    // transposed so byte i holds frame row framePage*8 + i across them
+    static uint64_t block(const Frame& frame, int framePage, int panelPage) {
+        uint64_t m = 0;
+        for(int i = 0; i < 8; i++) {
+            m |= static_cast<uint64_t>(frame.pageByte(framePage, panelPage*8 + i)) << (i*8);
+        }
+        return transpose8x8(m);
+    }
+
+    static uint8_t pageByte(const Frame& frame, int page, int x) {
+        const int y = Panel::WIDTH - 1 - x;
+        return (block(frame, y >> 3, page) >> ((y & 7) * 8)) & 0xFF;
+    }
+
+    // One transposed block serves up to 8 consecutive panel columns
+    static void pageRow(const Frame& frame, int page, int col0, int col1, uint8_t* out) {
+        int col = col0;
+        while(col <= col1) {
+            const int y = Panel::WIDTH - 1 - col;
+            const uint64_t rows = block(frame, y >> 3, page);
+            for(int i = y & 7; i >= 0 && col <= col1; i--, col++) {
+                *out++ = (rows >> (i*8)) & 0xFF;
+            }
+        }
+    }
+
+    // Frame page p covers panel columns Panel::WIDTH - 8 - 8p to Panel::WIDTH - 1 - 8p
+    static void spans(const int* start, const int* end, int* panelStart, int* panelEnd) {
+        for(int page = 0; page < Panel::PAGES; page++) {
+            panelStart[page] = Panel::WIDTH;
+            panelEnd[page] = -1;
+        }
+        for(int page = 0; page < Frame::PAGES; page++) {
+            if(start[page] > end[page]) {
+                continue;
+            }
+            const int col0 = Panel::WIDTH - 8 - page*8;
+            for(int panelPage = start[page] >> 3; panelPage <= end[page] >> 3; panelPage++) {
+                panelStart[panelPage] = std::min(panelStart[panelPage], col0);
+                panelEnd[panelPage] = std::max(panelEnd[panelPage], col0 + 7);
+            }
+        }
+    }
+
+    static void rect(int& x0, int& y0, int& x1, int& y1) {
+        const int top = y0;
+        const int bottom = y1;
+        y0 = x0;
+        y1 = x1;
+        x0 = Panel::WIDTH - 1 - bottom;
+        x1 = Panel::WIDTH - 1 - top;
+    }
+};
+
+#endif // SSD1306_LAYOUT_H
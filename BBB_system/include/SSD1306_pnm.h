@@ -0,0 +1,65 @@
+// SSD1306_pnm.h header file
+
+#ifndef SSD1306_PNM_H
+#define SSD1306_PNM_H
+
+#include <iostream>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstdint>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include "SSD1306_image.h"
+
+// Largest width and height accepted, keeps row offsets well inside a 32 bit size_t
+#define PNM_MAX_SIZE 16384
+
+// Binary PBM (P4) or PGM (P5) image read in place from memory or from a
+// memory mapped file. Nothing is decoded up front: readColumns() turns just
+// the requested rectangle into column words, so a splash screen or icon can
+// be drawn from the SD card without holding a decoded copy of the file.
+class PnmImage {
+    public:
+
+        PnmImage(const uint8_t* data, size_t size);
+
+        PnmImage(const std::string& path);
+
+        ~PnmImage();
+
+        PnmImage(const PnmImage&) = delete;
+
+        PnmImage& operator=(const PnmImage&) = delete;
+
+        bool isValid() const;
+
+        bool isBitmap() const;
+
+        int getWidth() const;
+
+        int getHeight() const;
+
+        void readColumns(int sx, int sy, int width, int height, uint64_t* columns, DitherMode mode) const;
+
+    private:
+        void parse();
+
+        const uint8_t* row(int y) const;
+
+        const uint8_t* data;    // Whole file, header included
+        size_t size;
+        size_t mapped;          // Length of the mapping, 0 when the data belongs to the caller
+        bool bitmap;            // P4, otherwise P5
+        int width;
+        int height;
+        int maxValue;           // Gray level of white, two bytes per pixel above 255
+        size_t pixelsOffset;    // First byte after the header
+        size_t rowBytes;
+};
+
+#endif // SSD1306_PNM_H
@@ -0,0 +1,50 @@
+// SSD1306_sprite.h header file
+
+#ifndef SSD1306_SPRITE_H
+#define SSD1306_SPRITE_H
+
+#include <cstdint>
+#include <vector>
+#include "SSD1306_bitmap.h"
+
+// Row offsets a sprite can be drawn at, from fully above the panel to the last row
+#define SPRITE_MIN_Y -63
+#define SPRITE_MAX_Y 63
+
+// Bitmap registered with the driver for animation. The columns shifted to
+// each row offset are computed the first time the offset is used and kept,
+// so moving a sprite is a masked operation per column without any shifting.
+class Sprite {
+    public:
+
+        Sprite(const Bitmap& bitmap, RasterOp op);
+
+        const uint64_t* columns(int y);
+
+        uint64_t mask(int y) const;
+
+        int getWidth() const;
+
+        int getHeight() const;
+
+        RasterOp getOp() const;
+
+        void setPosition(int x, int y);
+
+        int getX() const;
+
+        int getY() const;
+
+        void setVisible(bool is_visible);
+
+        bool isVisible() const;
+
+    private:
+        Bitmap bitmap;
+        RasterOp op;                                // How the sprite is drawn, XOR sprites keep the background
+        std::vector<std::vector<uint64_t>> shifts;  // Shifted columns for each row offset, empty until used
+        int x, y;                                   // Position of the top left corner
+        bool visible;                               // Sprite is drawn in the frame buffer
+};
+
+#endif // SSD1306_SPRITE_H
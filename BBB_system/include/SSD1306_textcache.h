@@ -0,0 +1,78 @@
+// SSD1306_textcache.h header file
+
+#ifndef SSD1306_TEXTCACHE_H
+#define SSD1306_TEXTCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "SSD1306_font.h"
+
+// Text runs kept by default, a screen of menu labels, a title and a message
+#define TEXT_CACHE_RUNS 32
+
+// A line of text rendered in a font, bit 0 of each column is the top row of
+// the line. The columns start left pixels from the pen position, ink left of
+// the pen (a negative bearing) makes it negative.
+struct TextRun {
+    int left;                       // First column relative to the pen position
+    int advance;                    // Width of the text as Font::measure() has it
+    int height;                     // Rows of the font
+    std::vector<uint64_t> columns;
+};
+
+// Lookups of a TextCache
+struct TextCacheStats {
+    uint64_t hits;                  // Runs found in the cache
+    uint64_t misses;                // Runs rendered from the font
+    uint64_t evictions;             // Least recently used runs dropped for new ones
+};
+
+// Least recently used cache of rendered text runs. Labels, titles and
+// messages are mostly the same from frame to frame, with the run cached
+// drawing them is a shift and a masked write per column instead of decoding,
+// glyph lookups and kerning for every character. Runs are keyed by the font
+// revision and the text, a font that changes or goes away gets a new
+// revision so its old runs are never hit again and age out. The rows are
+// not part of the key, a column word is shifted to any row by one shift.
+//
+// The cache is a handful of slots scanned in order: a lookup hashes the text
+// once and compares the hash and revision of each slot, the text itself
+// only on a match. A hit allocates nothing and moves nothing, it only stamps
+// the slot as used.
+class TextCache {
+    public:
+
+        TextCache(size_t capacity = TEXT_CACHE_RUNS);
+
+        const TextRun& run(const Font& font, const std::string& text);
+
+        void clear();
+
+        size_t size() const;
+
+        size_t getCapacity() const;
+
+        TextCacheStats getStats() const;
+
+    private:
+        // Key of a slot, kept apart from the texts and runs so a lookup scans one small array
+        struct Slot {
+            uint32_t hash;
+            uint32_t revision;      // Font revision, 0 for an empty slot
+            uint32_t used;          // Lookup clock of the last use
+        };
+
+        static uint32_t hash(const std::string& text);
+
+        static void render(const Font& font, const std::string& text, TextRun& run);
+
+        std::vector<Slot> slots;
+        std::vector<std::string> texts;
+        std::vector<TextRun> runs;
+        uint32_t clock;             // Counts lookups, orders the slots by use
+        TextCacheStats stats;
+};
+
+#endif // SSD1306_TEXTCACHE_H
@@ -0,0 +1,146 @@
+// SSD1306_transport.h header file
+
+#ifndef SSD1306_TRANSPORT_H
+#define SSD1306_TRANSPORT_H
+
+#include <iostream>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <linux/spi/spidev.h>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// Control bytes prefixed to every message
+#define CTRL_COMMAND 0x00
+#define CTRL_DATA 0x40
+#define CTRL_CONTINUATION 0x80
+
+// No operation command, used to check the display answers
+#define CMD_NOP 0xE3
+
+// Bus traffic counters of a transport
+struct TransportStats {
+    uint64_t flushes;         // Batches submitted with flush()
+    uint64_t transactions;    // Messages put on the bus
+    uint64_t bytes;           // Message bytes including control bytes
+    uint64_t errors;          // Failed batches
+};
+
+// Queues SSD1306 command and data messages and hands them to the bus in
+// batches. Every message starts with its i2c control byte, transports that
+// signal data/command some other way strip it before sending.
+class Transport {
+    public:
+
+        Transport();
+
+        virtual ~Transport();
+
+        virtual bool open() = 0;
+
+        virtual void close() = 0;
+
+        virtual bool isOpen() const = 0;
+
+        void queueCommand(const uint8_t* commands, size_t len);
+
+        void queueData(const uint8_t* data, size_t len);
+
+        uint8_t* reserveData(size_t len);
+
+        void queueMessage(const uint8_t* message, size_t len);
+
+        int flush();
+
+        void discard();
+
+        int probe();
+
+        size_t pending() const;
+
+        const TransportStats& getStats() const;
+
+        void resetStats();
+
+    protected:
+        struct Message {
+            const uint8_t* external;    // Caller owned message or nullptr when stored in the arena
+            size_t offset;              // Offset into the arena
+            size_t len;                 // Message length including the control byte
+        };
+
+        const uint8_t* messageBuffer(const Message& msg) const;
+
+        // Puts the messages on the bus, returns 0 or -errno
+        virtual int submit(const std::vector<Message>& messages) = 0;
+
+    private:
+        uint8_t* queueOwned(uint8_t control, size_t len);
+
+        std::vector<Message> queue;     // Messages waiting for flush()
+        std::vector<uint8_t> arena;     // Storage for copied messages
+        TransportStats stats;
+};
+
+// Submits a whole batch of messages with a single I2C_RDWR ioctl instead of
+// one write() per message
+class I2CTransport : public Transport {
+    public:
+
+        I2CTransport(const int bus, const uint8_t address);
+
+        ~I2CTransport();
+
+        bool open() override;
+
+        void close() override;
+
+        bool isOpen() const override;
+
+    protected:
+        int submit(const std::vector<Message>& messages) override;
+
+    private:
+        const int bus;                  // The i2c bus number
+        const uint8_t address;          // Slave address of the display
+        int file;                       // File descriptor for i2c communication
+};
+
+// 4-wire SPI through spidev, the D/C line is a sysfs gpio. Consecutive
+// messages of the same kind go out in one SPI_IOC_MESSAGE ioctl.
+class SPITransport : public Transport {
+    public:
+
+        SPITransport(const int bus, const int chipSelect, const int dcPin, const uint32_t speed);
+
+        ~SPITransport();
+
+        bool open() override;
+
+        void close() override;
+
+        bool isOpen() const override;
+
+    protected:
+        int submit(const std::vector<Message>& messages) override;
+
+    private:
+        bool setDataMode(bool is_data);
+
+        const int bus;                  // The spidev bus number
+        const int chipSelect;           // The spidev chip select
+        const int dcPin;                // Gpio number of the D/C line
+        const uint32_t speed;           // Clock speed in Hz
+        int file;                       // File descriptor for spidev
+        int dcFile;                     // File descriptor for the D/C gpio value
+        int dcState;                    // Current D/C level, -1 when unknown
+};
+
+#endif // SSD1306_TRANSPORT_H
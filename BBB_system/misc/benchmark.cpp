@@ -0,0 +1,645 @@
+/*
+SSD1306 flush and UI benchmark, runs against the in-process emulator on any Linux host
+
+g++ -O2 -Iinclude misc/benchmark.cpp src/SSD1306.cpp src/SSD1306_canvas.cpp src/SSD1306_bitmap.cpp src/SSD1306_image.cpp src/SSD1306_pnm.cpp src/SSD1306_font.cpp src/SSD1306_textcache.cpp src/SSD1306_sprite.cpp src/SSD1306_transport.cpp src/SSD1306_emulator.cpp src/BBB_sys.cpp src/BBB_gpio.cpp -lpthread -o benchmark
+*/
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <type_traits>
+#include <fstream>
+#include <cstdio>
+#include "SSD1306.h"
+#include "SSD1306_emulator.h"
+#include "SSD1306_image.h"
+#include "BBB_sys.h"
+
+// Bus time of the recorded traffic on a 400 kHz i2c bus: 9 clocks per byte
+// plus START, address byte and STOP for every transaction
+double busMilliseconds(const TransportStats& stats) {
+    return (stats.bytes * 9.0 + stats.transactions * 11.0) / 400000.0 * 1000.0;
+}
+
+// Compares what the emulated panel shows with the driver frame buffer. The
+// panel sees the GRAM columns from the layout's column offset onwards, its
+// pixels come from the frame through the layout's panel mapping and are
+// mirrored by the orientation.
+template<class Driver>
+bool panelMatches(Driver& display, const SSD1306Emulator& emulator) {
+
+    typedef typename std::decay<decltype(display.getFrame())>::type Layout;
+    typedef typename PanelMap<Layout>::Panel Panel;
+    const Orientation orientation = display.getOrientation();
+    uint64_t panel[EMU_COLUMNS];
+    emulator.readDisplay(panel);
+
+    for(int x = 0; x < Panel::WIDTH; x++) {
+        for(int y = 0; y < Panel::HEIGHT; y++) {
+            const int frameX = (orientation & ORIENT_MIRROR_X) ? Panel::WIDTH - 1 - x : x;
+            const int frameY = (orientation & ORIENT_MIRROR_Y) ? Panel::HEIGHT - 1 - y : y;
+            const bool shown = (panel[x + Panel::COLUMN_OFFSET] >> y) & 1;
+
+            if(shown != PanelMap<Layout>::pixel(display.getFrame(), frameX, frameY)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<class Driver>
+void runScene(const std::string& name, Driver& display, SSD1306Emulator& emulator, int frames, const std::function<void(int)>& draw) {
+
+    emulator.resetStats();
+    auto start = std::chrono::steady_clock::now();
+
+    for(int frame = 0; frame < frames; frame++) {
+        draw(frame);
+        display.renderDisplay(0, Driver::PAGES - 1);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double cpu_us = std::chrono::duration<double, std::micro>(end - start).count() / frames;
+    const TransportStats& stats = emulator.getStats();
+
+    std::cout << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(1)
+        << std::setw(10) << cpu_us << " us"
+        << std::setw(10) << static_cast<double>(stats.bytes) / frames << " B"
+        << std::setw(8) << static_cast<double>(stats.transactions) / frames << " msg"
+        << std::setw(8) << static_cast<double>(stats.flushes) / frames << " call"
+        << std::setw(10) << std::setprecision(2) << busMilliseconds(stats) / frames << " ms bus"
+        << (panelMatches(display, emulator) ? "" : "   PANEL MISMATCH") << std::endl;
+}
+
+// Driver level scenes for one frame buffer layout
+template<class Driver>
+void runLayout(const std::string& layout, int frames) {
+
+    SSD1306Emulator emulator;
+    Driver display(emulator);
+
+    if(!display.begin()) {
+        std::cerr << "Failed to initialize display\n";
+        return;
+    }
+
+    runScene(layout + " idle", display, emulator, frames, [&](int) {
+        display.clearBuffer();
+        display.getCanvas().drawRectangle(0, 0, 127, 63, WHITE);
+        display.getCanvas().drawText("BEAGLE sys", 2, 2);
+        display.getCanvas().drawText("12:00", 70, 2);
+    });
+
+    runScene(layout + " clock", display, emulator, frames, [&](int frame) {
+        display.clearBuffer();
+        display.getCanvas().drawRectangle(0, 0, 127, 63, WHITE);
+        display.getCanvas().drawText("BEAGLE sys", 2, 2);
+        display.getCanvas().drawText("12:0" + std::to_string(frame % 10), 70, 2);
+    });
+
+    runScene(layout + " text", display, emulator, frames, [&](int frame) {
+        display.clearBuffer();
+        for(int row = 0; row < 7; row++) {
+            display.getCanvas().drawText("Line " + std::to_string(frame + row) + " of text", 0, row * 8 + frame % 2);
+        }
+    });
+
+    runScene(layout + " shapes", display, emulator, frames, [&](int frame) {
+        display.clearBuffer();
+        display.getCanvas().fillCircle(20 + frame % 80, 32, 15, WHITE);
+        display.getCanvas().drawLine(0, 63, frame % 128, 0, 2, WHITE);
+        display.getCanvas().fillRectangle(100, 10, 120, 10 + frame % 50, WHITE);
+    });
+
+    runScene(layout + " full redraw", display, emulator, frames, [&](int frame) {
+        display.clearBuffer();
+        display.getCanvas().fillRectangle(0, 0, 127, 63, frame % 2);
+    });
+
+    // Static screen drawn once offscreen and copied in before the changing parts
+    typename std::remove_reference<decltype(display.getCanvas())>::type background;
+    background.drawRectangle(0, 0, 127, 63, WHITE);
+    background.drawText("BEAGLE sys", 2, 2);
+    background.drawHrzLine(0, 127, 12, WHITE);
+    background.fillCircle(100, 40, 15, WHITE);
+
+    runScene(layout + " canvas blit", display, emulator, frames, [&](int frame) {
+        display.getCanvas().blit(background, 0, 0, Driver::WIDTH, Driver::HEIGHT, 0, 0, ROP_COPY);
+        display.getCanvas().drawText("12:0" + std::to_string(frame % 10), 70, 2);
+    });
+
+    // A vertical gauge flushed on its own, as BBB_i2c_oled::updateProgressBarVrt does
+    runScene(layout + " gauge region", display, emulator, frames, [&](int frame) {
+        display.getCanvas().fillRectangle(115, 5, 120, 58, BLACK);
+        display.getCanvas().drawRectangle(115, 5, 120, 58, WHITE);
+        display.getCanvas().fillRectangle(117, 7, 118, 7 + (frame * 7) % 50, WHITE);
+        display.updateRegion(115, 5, 120, 58);
+    });
+
+    // Four XOR sprites moving over a static background
+    Bitmap ball(12, 12);
+    for(int x = 0; x < 12; x++) {
+        for(int y = 0; y < 12; y++) {
+            ball.setPixel(x, y, (x - 6) * (x - 6) + (y - 6) * (y - 6) <= 30);
+        }
+    }
+    display.clearBuffer();
+    display.getCanvas().drawRectangle(0, 0, 127, 63, WHITE);
+    display.getCanvas().drawText("BEAGLE sys", 2, 2);
+
+    int balls[4];
+    for(int i = 0; i < 4; i++) {
+        balls[i] = display.addSprite(ball, ROP_XOR);
+    }
+
+    runScene(layout + " sprites", display, emulator, frames, [&](int frame) {
+        for(int i = 0; i < 4; i++) {
+            display.moveSprite(balls[i], (frame * (i + 1) + 30 * i) % 116, 8 + (frame * (i + 2) + 11 * i) % 44);
+        }
+    });
+
+    // A message log redrawn line by line against the same log scrolled with the start line
+    runScene(layout + " log redraw", display, emulator, frames, [&](int frame) {
+        display.clearBuffer();
+        for(int row = 0; row < Driver::PAGES; row++) {
+            display.getCanvas().drawText("msg " + std::to_string(frame + row) + ": sensor ok", 0, row * 8);
+        }
+    });
+
+    runScene(layout + " log console", display, emulator, frames, [&](int frame) {
+        display.consoleLine("msg " + std::to_string(frame + Driver::PAGES) + ": sensor ok");
+    });
+
+    // Producer side cost with the flush thread overlapping the bus transfer
+    display.startFlushThread();
+    double present_us = 0;
+
+    for(int frame = 0; frame < frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        display.clearBuffer();
+        display.getCanvas().fillCircle(20 + frame % 80, 32, 15, WHITE);
+        display.getCanvas().drawText("frame " + std::to_string(frame), 2, 2);
+        display.present();
+        present_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        // Rest of the main loop
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    display.stopFlushThread();
+    SSD1306Stats stats = display.getStats();
+
+    std::cout << std::left << std::setw(26) << layout + " async present" << std::right << std::fixed << std::setprecision(1)
+        << std::setw(10) << present_us << " us   "
+        << stats.framesPresented << " presented, " << stats.framesFlushed << " flushed, "
+        << stats.framesDropped << " dropped" << std::endl;
+
+    // The gauge region between whole frames with the flush thread running, a
+    // frame sent after a region must not cover it with older pixels
+    display.startFlushThread();
+    display.clearBuffer();
+    display.getCanvas().drawText("gauge", 2, 2);
+    display.renderDisplay(0, Driver::PAGES - 1);
+
+    for(int frame = 0; frame < frames; frame++) {
+        display.getCanvas().fillRectangle(115, 5, 120, 58, BLACK);
+        display.getCanvas().drawRectangle(115, 5, 120, 58, WHITE);
+        display.getCanvas().fillRectangle(117, 7, 118, 7 + (frame * 7) % 50, WHITE);
+        display.updateRegion(115, 5, 120, 58);
+
+        if(frame % 10 == 0) {
+            display.getCanvas().drawText("frame " + std::to_string(frame), 2, 20);
+            display.renderDisplay(0, Driver::PAGES - 1);
+        }
+    }
+    display.stopFlushThread();
+
+    std::cout << std::left << std::setw(26) << layout + " async gauge" << std::right
+        << (panelMatches(display, emulator) ? "matches" : "   PANEL MISMATCH") << std::endl;
+}
+
+// Average time of one call of the drawing function in microseconds
+double timeDraw(int calls, const std::function<void(int)>& draw) {
+
+    auto start = std::chrono::steady_clock::now();
+    for(int call = 0; call < calls; call++) {
+        draw(call);
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+// Filling primitives against the per pixel loop they used to be
+template<class Driver>
+void runPrimitives(const std::string& layout, int calls) {
+
+    SSD1306Emulator emulator;
+    Driver display(emulator);
+
+    auto report = [&](const std::string& name, double us) {
+        std::cout << std::left << std::setw(26) << layout + " " + name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(10) << us << " us" << std::endl;
+    };
+
+    report("pixel fill", timeDraw(calls, [&](int call) {
+        for(int x = 0; x < Driver::WIDTH; x++) {
+            for(int y = 0; y < Driver::HEIGHT; y++) {
+                display.getCanvas().drawPixel(x, y, call & 1);
+            }
+        }
+    }));
+    report("fillRectangle", timeDraw(calls, [&](int call) {
+        display.getCanvas().fillRectangle(0, 0, Driver::WIDTH - 1, Driver::HEIGHT - 1, call & 1);
+    }));
+    report("fillCircle r30", timeDraw(calls, [&](int call) {
+        display.getCanvas().fillCircle(64, 32, 30, call & 1);
+    }));
+    report("line w3", timeDraw(calls, [&](int call) {
+        display.getCanvas().drawLine(0, 63, 127, call % 64, 3, call & 1);
+    }));
+    report("fillTriangle", timeDraw(calls, [&](int call) {
+        display.getCanvas().fillTriangle(10, 60, 64, call % 64, 120, 50, call & 1);
+    }));
+    std::vector<Point> chart;
+    for(int x = 0; x < 128; x += 8) {
+        chart.push_back({x, 32 + ((x * 37) % 29) - 14});
+    }
+    report("polyline w2", timeDraw(calls, [&](int call) {
+        display.getCanvas().drawPolyline(chart, 2, call & 1);
+    }));
+    Bitmap icon(16, 16);
+    for(int i = 0; i < 16; i++) {
+        icon.setPixel(i, i, true);
+        icon.setPixel(15 - i, i, true);
+    }
+    report("blit 16x16 XOR", timeDraw(calls, [&](int call) {
+        display.getCanvas().blit(icon, call % 120, call % 50 - 4, ROP_XOR);
+    }));
+    report("status text", timeDraw(calls, [&](int call) {
+        display.getCanvas().drawText("BEAGLE sys", 2, 2);
+        display.getCanvas().drawText((call & 1) ? "12:05" : "12:06", 70, 2, ROP_COPY);
+    }));
+    report("UI boxes", timeDraw(calls, [&](int call) {
+        display.getCanvas().drawRectangle(0, 0, 127, 63, WHITE);
+        display.getCanvas().drawRectangle(5, 17, 60, 60, WHITE);
+        display.getCanvas().fillRectangle(7, 19, 58, 30, call & 1);
+        display.getCanvas().drawHrzLine(0, 127, 12, WHITE);
+        display.getCanvas().fillRectangle(117, 7, 118, 7 + call % 50, WHITE);
+    }));
+}
+
+// The circle functions as they were before the integer span versions, a
+// float decision variable and a drawPixel call for every point
+template<class Canvas>
+void pixelDrawCircle(Canvas& canvas, int x, int y, int radius, int color) {
+
+    float dp = 3 - 2 * radius;
+    int x1 = 0;
+    int y1 = radius;
+
+    while(x1 <= y1) {
+        if(dp <= 0) {
+            dp += (4 * x1) + 6;
+        } else {
+            dp += 4 * (x1 - y1) + 10;
+            y1--;
+        }
+        x1++;
+        canvas.drawPixel(x + x1, y + y1, color);
+        canvas.drawPixel(x + x1, y - y1, color);
+        canvas.drawPixel(x - x1, y + y1, color);
+        canvas.drawPixel(x - x1, y - y1, color);
+        canvas.drawPixel(x + y1, y + x1, color);
+        canvas.drawPixel(x + y1, y - x1, color);
+        canvas.drawPixel(x - y1, y + x1, color);
+        canvas.drawPixel(x - y1, y - x1, color);
+    }
+}
+
+template<class Canvas>
+void pixelFillCircle(Canvas& canvas, int x, int y, int radius, int color) {
+
+    int dp = 3 - 2 * radius;
+    int x1 = 0;
+    int y1 = radius;
+
+    while(x1 <= y1) {
+        for(int i = x - y1; i <= x + y1; i++) {
+            canvas.drawPixel(i, y + x1, color);
+            canvas.drawPixel(i, y - x1, color);
+        }
+        for(int i = x - x1; i <= x + x1; i++) {
+            canvas.drawPixel(i, y + y1, color);
+            canvas.drawPixel(i, y - y1, color);
+        }
+        if(dp <= 0) {
+            dp += (4 * x1) + 6;
+        } else {
+            dp += 4 * (x1 - y1) + 10;
+            y1--;
+        }
+        x1++;
+    }
+}
+
+// Circles of the sizes the UI uses, the pixel versions against the span versions
+template<class Driver>
+void runCircles(const std::string& layout, int calls) {
+
+    SSD1306Emulator emulator;
+    Driver display(emulator);
+    auto& canvas = display.getCanvas();
+
+    auto report = [&](const std::string& name, double old_us, double new_us) {
+        std::cout << std::left << std::setw(26) << layout + " " + name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(10) << old_us << " us" << std::setw(10) << new_us << " us"
+            << std::setprecision(1) << std::setw(8) << old_us / new_us << "x" << std::endl;
+    };
+
+    for(int radius : {4, 8, 16, 30}) {
+        const std::string r = " r" + std::to_string(radius);
+
+        report("circle" + r,
+            timeDraw(calls, [&](int call) { pixelDrawCircle(canvas, 64, 32, radius, call & 1); }),
+            timeDraw(calls, [&](int call) { canvas.drawCircle(64, 32, radius, call & 1); }));
+        report("disc" + r,
+            timeDraw(calls, [&](int call) { pixelFillCircle(canvas, 64, 32, radius, call & 1); }),
+            timeDraw(calls, [&](int call) { canvas.fillCircle(64, 32, radius, call & 1); }));
+    }
+    std::cout << std::left << std::setw(26) << layout + " arc r20 w3" << std::right << std::setprecision(2) << std::setw(23)
+        << timeDraw(calls, [&](int call) { canvas.drawArc(64, 32, 20, -45, 225, 3, call & 1); }) << " us" << std::endl;
+    std::cout << std::left << std::setw(26) << layout + " round rect r3" << std::right << std::setw(23)
+        << timeDraw(calls, [&](int call) { canvas.drawRoundRect(5, 17, 60, 60, 3, call & 1); }) << " us" << std::endl;
+}
+
+// A camera sized grayscale frame scaled down and dithered for the panel, the
+// conversion steps on their own and whole frames shown through the emulator
+void runImage(int frames) {
+
+    GrayImage camera(320, 240);
+    for(int y = 0; y < 240; y++) {
+        for(int x = 0; x < 320; x++) {
+            const int dx = x - 160;
+            const int dy = y - 120;
+            camera.row(y)[x] = std::max(0, 255 - (dx * dx + dy * dy) / 80) ^ ((x / 40 + y / 40) & 1 ? 0x40 : 0);
+        }
+    }
+    const GrayImage thumbnail = camera.scaled(SSD1306::WIDTH, SSD1306::HEIGHT);
+
+    auto report = [](const std::string& name, double us) {
+        std::cout << std::left << std::setw(26) << name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(10) << us << " us" << std::endl;
+    };
+
+    report("image scale 320x240", timeDraw(200, [&](int) { camera.scaled(SSD1306::WIDTH, SSD1306::HEIGHT); }));
+    report("image threshold", timeDraw(2000, [&](int) { thumbnail.dither(DITHER_THRESHOLD); }));
+    report("image bayer", timeDraw(2000, [&](int) { thumbnail.dither(DITHER_BAYER); }));
+    report("image floyd-steinberg", timeDraw(2000, [&](int) { thumbnail.dither(DITHER_FLOYD_STEINBERG); }));
+
+    SSD1306Emulator emulator;
+    SSD1306 display(emulator);
+    display.begin();
+
+    // The same picture as a PGM file and a full screen PBM splash in memory,
+    // drawn straight from the file bytes
+    std::string header = "P5\n320 240\n255\n";
+    std::vector<uint8_t> pgm(header.begin(), header.end());
+    for(int y = 0; y < 240; y++) {
+        pgm.insert(pgm.end(), camera.row(y), camera.row(y) + 320);
+    }
+    header = "P4\n128 64\n";
+    std::vector<uint8_t> pbm(header.begin(), header.end());
+    for(int i = 0; i < 16 * 64; i++) {
+        pbm.push_back((i * 37) ^ (i >> 4));
+    }
+    const PnmImage pgmImage(pgm.data(), pgm.size());
+    const PnmImage pbmImage(pbm.data(), pbm.size());
+
+    report("PBM 128x64 splash", timeDraw(2000, [&](int) { display.getCanvas().drawImage(pbmImage, 0, 0); }));
+    report("PGM 320x240 visible part", timeDraw(2000, [&](int call) {
+        display.getCanvas().drawImage(pgmImage, -(call % 192), -(call % 176), DITHER_BAYER);
+    }));
+
+    // The picture pans by a pixel every frame, as a live camera view would change
+    for(DitherMode mode : {DITHER_BAYER, DITHER_FLOYD_STEINBERG}) {
+        runScene(mode == DITHER_BAYER ? "camera bayer" : "camera floyd-steinberg", display, emulator, frames, [&](int frame) {
+            const int pan = frame % 64;
+            GrayImage view(camera.row(pan) + pan, 256, 128, camera.getWidth());
+            display.getCanvas().blit(view.toBitmap(SSD1306::WIDTH, SSD1306::HEIGHT, mode), 0, 0, ROP_COPY);
+        });
+    }
+}
+
+// Writes the built-in glyphs as a proportional BDF font: each glyph is cut
+// to its ink and advances one blank column past it
+void writeProportionalBDF(const std::string& path) {
+
+    std::ofstream bdf(path);
+    bdf << "STARTFONT 2.1\nFONT proportional-8\nSIZE 8 75 75\nFONTBOUNDINGBOX 6 8 0 0\n"
+        << "STARTPROPERTIES 3\nFONT_ASCENT 8\nFONT_DESCENT 0\nDEFAULT_CHAR 63\nENDPROPERTIES\nCHARS 95\n";
+
+    for(int code = 0x20; code < 0x7F; code++) {
+        const uint8_t* glyph = Font6x8::glyph(code);
+        int first = 0, last = 5;
+        while(first <= last && glyph[first] == 0) first++;
+        while(last >= first && glyph[last] == 0) last--;
+        const int width = (first <= last) ? last - first + 1 : 0;
+
+        bdf << "STARTCHAR c" << code << "\nENCODING " << code << "\nDWIDTH " << ((width > 0) ? width + 1 : 3) << " 0\n"
+            << "BBX " << width << " 8 0 0\nBITMAP\n";
+        for(int row = 0; row < 8; row++) {
+            int bits = 0;
+            for(int col = 0; col < width; col++) {
+                bits |= ((glyph[first + col] >> row) & 1) << (7 - col);
+            }
+            bdf << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << bits << std::dec << std::setfill(' ') << "\n";
+        }
+        bdf << "ENDCHAR\n";
+    }
+    bdf << "ENDFONT\n";
+}
+
+// Loading a BDF font the first time and from its cache afterwards, and how
+// much more of a message fits on a line than with the fixed 6 pixel advance
+void runFont() {
+
+    const std::string bdfPath = "/tmp/ssd1306_benchmark.bdf";
+    const std::string cachePath = "/tmp/ssd1306_benchmark.font";
+    writeProportionalBDF(bdfPath);
+    std::remove(cachePath.c_str());
+
+    auto report = [](const std::string& name, double us) {
+        std::cout << std::left << std::setw(26) << name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(10) << us << " us" << std::endl;
+    };
+
+    report("font BDF parse", timeDraw(1, [&](int) { Font parsed(bdfPath, cachePath); }));
+    report("font cache map", timeDraw(200, [&](int) { Font mapped(bdfPath, cachePath); }));
+
+    Font fixed;
+    Font proportional(bdfPath, cachePath);
+    proportional.setKerning('T', 'o', -1);
+
+    const std::string message = "Pump 2 pressure low, check the inlet filter";
+    std::cout << std::left << std::setw(26) << "font chars per 124 px" << std::right
+        << std::setw(10) << fixed.fit(message, 124) << " fixed" << std::setw(10) << proportional.fit(message, 124) << " proportional" << std::endl;
+
+    SSD1306Emulator emulator;
+    SSD1306 display(emulator);
+    display.begin();
+
+    report("font text line", timeDraw(2000, [&](int call) {
+        display.getCanvas().drawText(proportional, message, 2, call % 56);
+    }));
+
+    // A menu screen redrawn every frame, the labels measured and rendered
+    // glyph by glyph against measured and drawn from the text cache, each in a
+    // frame sized to it
+    const std::vector<std::string> labels = { "MESG", "STAT", "NETW", "TIME", "EXIT", "Viestit: 3 uutta, lämpötila 21°C" };
+    TextCache cache;
+
+    report("font text line cached", timeDraw(2000, [&](int call) {
+        display.getCanvas().drawText(cache, proportional, message, 2, call % 56);
+    }));
+    report("font menu", timeDraw(2000, [&](int call) {
+        for(size_t i = 0; i < labels.size(); i++) {
+            const int x = (i % 4) * 30 + 2, y = (i / 4) * 14 + call % 2 + 2;
+            const int width = fixed.measure(labels[i]);
+            display.getCanvas().drawText(fixed, labels[i], x, y);
+            display.getCanvas().drawRectangle(x - 2, y - 2, x + width, y + fixed.getHeight() + 1, WHITE);
+        }
+    }));
+    // One lookup per label measures and draws it, like the text boxes do
+    report("font menu cached", timeDraw(2000, [&](int call) {
+        for(size_t i = 0; i < labels.size(); i++) {
+            const int x = (i % 4) * 30 + 2, y = (i / 4) * 14 + call % 2 + 2;
+            const TextRun& run = cache.run(fixed, labels[i]);
+            display.getCanvas().drawRun(run, x, y);
+            display.getCanvas().drawRectangle(x - 2, y - 2, x + run.advance, y + run.height + 1, WHITE);
+        }
+    }));
+
+    const TextCacheStats stats = cache.getStats();
+    std::cout << std::left << std::setw(26) << "font text cache" << std::right
+        << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evictions" << std::endl;
+}
+
+// Status line and a bouncing box on the smaller panels, checks that the
+// init sequence and the column offset put the frame in the right place
+template<class Driver>
+void runPanel(const std::string& panel, int frames) {
+
+    SSD1306Emulator emulator;
+    Driver display(emulator);
+
+    if(!display.begin()) {
+        std::cerr << "Failed to initialize display\n";
+        return;
+    }
+
+    const int right = Driver::WIDTH - 1;
+    const int bottom = Driver::HEIGHT - 1;
+
+    runScene(panel + " status", display, emulator, frames, [&](int frame) {
+        display.clearBuffer();
+        display.getCanvas().drawRectangle(0, 0, right, bottom, WHITE);
+        display.getCanvas().drawText("12:0" + std::to_string(frame % 10), 2, 2);
+        int x = frame % (Driver::WIDTH - 8);
+        display.getCanvas().fillRectangle(x, bottom - 5, x + 5, bottom - 2, WHITE);
+    });
+
+    runScene(panel + " console", display, emulator, frames, [&](int frame) {
+        display.consoleLine("log " + std::to_string(frame));
+    });
+}
+
+// The same status screen turned with the controller's scan directions, and in
+// portrait on a turned panel where the flush transposes the frame
+template<class Driver>
+void runOrientation(const std::string& panel, int frames) {
+
+    SSD1306Emulator emulator;
+    Driver display(emulator);
+
+    if(!display.begin()) {
+        std::cerr << "Failed to initialize display\n";
+        return;
+    }
+
+    const int right = Driver::WIDTH - 1;
+    const int bottom = Driver::HEIGHT - 1;
+    const Orientation orientations[] = { ORIENT_NORMAL, ORIENT_MIRROR_X, ORIENT_ROTATE_180 };
+    const char* names[] = { " status", " mirrored", " 180" };
+
+    for(int i = 0; i < 3; i++) {
+        display.setOrientation(orientations[i]);
+
+        runScene(panel + names[i], display, emulator, frames, [&](int frame) {
+            display.clearBuffer();
+            display.getCanvas().drawRectangle(0, 0, right, bottom, WHITE);
+            display.getCanvas().drawText("12:0" + std::to_string(frame % 10), 2, 2);
+            int y = frame % (Driver::HEIGHT - 20);
+            display.getCanvas().fillRectangle(right - 7, y + 12, right - 2, y + 17, WHITE);
+        });
+    }
+}
+
+int main() {
+
+    const int frames = 200;
+
+    std::cout << "Per frame averages over " << frames << " frames" << std::endl;
+
+    runLayout<SSD1306Driver<ColumnMajor<128, 64>>>("column-major", frames);
+    runLayout<SSD1306Driver<PageMajor<128, 64>>>("page-major", frames);
+    runPrimitives<SSD1306Driver<ColumnMajor<128, 64>>>("column-major", 2000);
+    runPrimitives<SSD1306Driver<PageMajor<128, 64>>>("page-major", 2000);
+    std::cout << std::left << std::setw(26) << "Circles" << std::right << std::setw(13) << "pixels" << std::setw(13) << "spans" << std::endl;
+    runCircles<SSD1306Driver<ColumnMajor<128, 64>>>("column-major", 2000);
+    runCircles<SSD1306Driver<PageMajor<128, 64>>>("page-major", 2000);
+    runImage(frames);
+    runFont();
+    runPanel<SSD1306Driver<ColumnMajor<128, 32>>>("128x32", frames);
+    runPanel<SSD1306Driver<ColumnMajor<96, 16>>>("96x16", frames);
+    runPanel<SSD1306Driver<PageMajor<64, 48>>>("64x48", frames);
+    runOrientation<SSD1306Driver<ColumnMajor<64, 48>>>("64x48", frames);
+    runOrientation<SSD1306Driver<QuarterTurn<ColumnMajor<48, 64>>>>("48x64 portrait", frames);
+    runOrientation<SSD1306Driver<QuarterTurn<PageMajor<48, 64>>>>("48x64 page-major", frames);
+
+    // Display unplugged for 50 ms and plugged back in while frames keep coming every millisecond
+    SSD1306Emulator replug_emulator;
+    SSD1306 replug_display(replug_emulator);
+    replug_display.begin();
+
+    for(int frame = 0; frame < frames; frame++) {
+        if(frame == 50) replug_emulator.setConnected(false);
+        if(frame == 100) replug_emulator.setConnected(true);
+
+        replug_display.clearBuffer();
+        replug_display.getCanvas().drawRectangle(0, 0, SSD1306::WIDTH - 1, SSD1306::HEIGHT - 1, WHITE);
+        replug_display.getCanvas().drawText("frame " + std::to_string(frame), 2, 2);
+        replug_display.renderDisplay(0, SSD1306::PAGES - 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    SSD1306Stats replug_stats = replug_display.getStats();
+
+    std::cout << std::left << std::setw(26) << "replug" << std::right
+        << replug_stats.busErrors << " bus errors, " << replug_stats.offlineSkips << " skipped, "
+        << replug_stats.probes << " probes, " << replug_stats.recoveries << " recoveries"
+        << (panelMatches(replug_display, replug_emulator) ? "" : "   PANEL MISMATCH") << std::endl;
+
+    // The whole menu UI of BBB_sys::System rendered through the same emulator
+    SSD1306Emulator system_emulator;
+    BBB_sys::System system(system_emulator);
+    SSD1306& system_display = *system.getOLED().getDisplay();
+
+    runScene("System UI", system_display, system_emulator, frames, [&](int frame) {
+        system_display.clearBuffer();
+        if(frame % 20 == 0) {
+            system.getMain_menu().scrollDown();
+        }
+        system.getMain_menu().updateMenu(5, 20);
+        system.init_frame();
+    });
+
+    return 0;
+}
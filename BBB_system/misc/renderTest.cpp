@@ -16,7 +16,7 @@ int main() {
     
     for(int i = 0; i < 64; i += 8) {
 
-            display.draw_8(display.ASCIImap(static_cast<char>(0xFF)), 8, 2*i, i);
+            display.getCanvas().draw_8(SSD1306Canvas::ASCIImap(static_cast<char>(0xFF)), 8, 2*i, i);
     }
 
     display.renderDisplay(0,7);
@@ -27,22 +27,22 @@ int main() {
 
     for(int i = 0; i < 5; i++) {
         display.clearBuffer();
-        display.drawRectangle(i,i,i+30,i+30, WHITE);
-        display.drawRectangle(2*i,2*i,2*i+30,2*i+30, WHITE);
-        display.drawText("miumau ^(>.<)^", i, i);
-        display.draw_8(display.ASCIImap(static_cast<char>(0xFF)), 8, 2*i, i);
+        display.getCanvas().drawRectangle(i,i,i+30,i+30, WHITE);
+        display.getCanvas().drawRectangle(2*i,2*i,2*i+30,2*i+30, WHITE);
+        display.getCanvas().drawText("miumau ^(>.<)^", i, i);
+        display.getCanvas().draw_8(SSD1306Canvas::ASCIImap(static_cast<char>(0xFF)), 8, 2*i, i);
         display.renderDisplay(0,7);
     }
 
     display.clearBuffer();
 
-    display.drawTriangle(30, 10, 10, 50, 70, 45, 5, WHITE);
+    display.getCanvas().drawTriangle(30, 10, 10, 50, 70, 45, 5, WHITE);
 
     for(int i = 0; i < 10; i++) {
 
         int color = (i % 2 == 0) ? WHITE : BLACK;
 
-        display.drawEqTriangle(50 + (3*i), 5 + i, 20 + 2*i, 3, color);
+        display.getCanvas().drawEqTriangle(50 + (3*i), 5 + i, 20 + 2*i, 3, color);
 
         display.renderDisplay(0,7);
     }
@@ -51,25 +51,37 @@ int main() {
         
         int color = (i % 2 == 0) ? BLACK : WHITE;
 
-        display.drawEqTriangle(50 + (3*i), 5 + i, 20 + 2*i, 3, color);
+        display.getCanvas().drawEqTriangle(50 + (3*i), 5 + i, 20 + 2*i, 3, color);
 
         display.renderDisplay(0,7);
     }
 
     display.clearBuffer();
-    display.drawCircle(62, 30, 15, WHITE);
+    display.getCanvas().drawCircle(62, 30, 15, WHITE);
     display.renderDisplay(0,7);
-    display.fillCircle(70, 30, 15, WHITE);
+    display.getCanvas().fillCircle(70, 30, 15, WHITE);
     display.renderDisplay(0,7);
-    display.drawCircle(75, 30, 15, BLACK);
+    display.getCanvas().drawCircle(75, 30, 15, BLACK);
     display.renderDisplay(0,7);
     display.inverseDisplay(true);
 
     display.clearDisplay();
 
+    // The sliding text is a sprite, each step only moves its columns
+    const std::string slideText = "Softa liuku !#¤%";
+    Bitmap slideBitmap(Font6x8::measure(slideText), 8);
+
+    size_t next = 0;
+    for(int x = 0; x < slideBitmap.getWidth(); x += 6) {
+        const uint8_t* glyph = Font6x8::unicode(nextCodePoint(slideText, next));
+        for(int col = 0; col < 6; col++) {
+            slideBitmap.setColumn(x + col, glyph[col]);
+        }
+    }
+    int slider = display.addSprite(slideBitmap, ROP_OR);
+
     for(int i = 0; i < 50; i++) {
-        display.clearBuffer();
-        display.drawText("Softa liuku !#¤%", 10 + 2*i, 10 + i);
+        display.moveSprite(slider, 10 + 2*i, 10 + i);
         display.renderDisplay(0,7);
         
     }
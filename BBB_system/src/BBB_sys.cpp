@@ -26,7 +26,15 @@ namespace BBB_sys {
         return connection_check == 0;
     }
 
-    BBB_i2c_oled::BBB_i2c_oled(const int bus) : display(bus) {
+    BBB_i2c_oled::BBB_i2c_oled(const int bus) : display(bus), font(new Font()) {
+
+        if(!this->display.begin()) {
+            std::cerr << "Failed to initialize display\n";
+        }
+        init();
+    }
+
+    BBB_i2c_oled::BBB_i2c_oled(Transport& transport) : display(transport), font(new Font()) {
 
         if(!this->display.begin()) {
             std::cerr << "Failed to initialize display\n";
@@ -35,18 +43,17 @@ namespace BBB_sys {
     }
 
     BBB_i2c_oled::~BBB_i2c_oled() {
-        this->display.~SSD1306();
         std::cout << "Display object deleted" << std::endl;
     }
 
     void BBB_i2c_oled::init() {
 
         this->display.clearBuffer();
-        this->display.drawCircle(62, 30, 15, WHITE);
+        this->display.getCanvas().drawCircle(62, 30, 15, WHITE);
         this->display.renderDisplay(0,7);
-        this->display.fillCircle(70, 30, 15, WHITE);
+        this->display.getCanvas().fillCircle(70, 30, 15, WHITE);
         this->display.renderDisplay(0,7);
-        this->display.drawCircle(75, 30, 15, BLACK);
+        this->display.getCanvas().drawCircle(75, 30, 15, BLACK);
         this->display.renderDisplay(0,7);
         this->display.inverseDisplay(true);
         std::this_thread::sleep_for(std::chrono::milliseconds(750));
@@ -55,43 +62,122 @@ namespace BBB_sys {
         this->display.renderDisplay(0,7);
     }
 
+    // Loads a proportional BDF font for the text boxes, parsed once into the
+    // cache file and mapped from it on later boots. The current font stays
+    // if the file can't be read.
+    bool BBB_i2c_oled::loadFont(const std::string& bdfPath, const std::string& cachePath) {
+
+        std::unique_ptr<Font> loaded(new Font(bdfPath, cachePath));
+
+        if(!loaded->isValid()) {
+            return false;
+        }
+        this->font = std::move(loaded);
+        this->textCache.clear();
+        return true;
+    }
+
+    const Font& BBB_i2c_oled::getFont() const {
+        return *this->font;
+    }
+
+    // Hits and misses of the text box line cache
+    TextCacheStats BBB_i2c_oled::getTextCacheStats() const {
+        return this->textCache.getStats();
+    }
+
+    // Text boxes are drawn in their own viewport, a box partly off the
+    // screen or outside the caller's clip rectangle is cut at the edge. They
+    // are sized to the text as measured in the text box font. Lines are
+    // rendered once and drawn from the text cache while they stay the same.
+
     void BBB_i2c_oled::textBox(const std::vector<std::string>& text, int x, int y) {
 
-        size_t maxLineLength = 0;
-        int rowIndex = 0;
-        
-        for(const std::string& row : text) {
+        drawTextBox(text, lookupLines(text), x, y);
+    }
 
-            maxLineLength = std::max(maxLineLength, row.length());
+    void BBB_i2c_oled::textBox(const std::string& text, int x, int y) {
+
+        drawTextBox(this->textCache.run(*this->font, text), x, y);
+    }
 
-            this->display.drawText(row, x + 2, y + (rowIndex * 8) + 2);
+    // Looks every line up in the text cache once, the runs measure the box
+    // and are drawn into it. Past the capacity of the cache a lookup could
+    // evict the first runs, lines after that are measured and drawn uncached.
+    int BBB_i2c_oled::lookupLines(const std::vector<std::string>& text) {
 
-            rowIndex++;
+        int maxLineWidth = 0;
+
+        this->lines.clear();
+        for(size_t rowIndex = 0; rowIndex < text.size(); rowIndex++) {
+            if(rowIndex < this->textCache.getCapacity()) {
+                const TextRun& line = this->textCache.run(*this->font, text[rowIndex]);
+                this->lines.push_back(&line);
+                maxLineWidth = std::max(maxLineWidth, line.advance);
+            }
+            else {
+                this->lines.push_back(nullptr);
+                maxLineWidth = std::max(maxLineWidth, this->font->measure(text[rowIndex]));
+            }
         }
+        return maxLineWidth;
+    }
+
+    void BBB_i2c_oled::drawTextBox(const std::vector<std::string>& text, int maxLineWidth, int x, int y) {
+
+        const int lineHeight = this->font->getHeight();
+        int height = text.size() * lineHeight + 5;
+        int width = maxLineWidth + 3;
+
+        SSD1306Canvas& canvas = this->display.getCanvas();
+        canvas.pushViewport(x, y, width, height);
 
-        int y_end = y + text.size() * 8 + 4;
-        int x_end = x + maxLineLength * 6 + 2;
-        this->display.drawRectangle(x, y, x_end, y_end, WHITE);
+        for(size_t rowIndex = 0; rowIndex < text.size(); rowIndex++) {
+            if(this->lines[rowIndex] != nullptr) {
+                canvas.drawRun(*this->lines[rowIndex], 2, (rowIndex * lineHeight) + 2);
+            }
+            else {
+                canvas.drawText(*this->font, text[rowIndex], 2, (rowIndex * lineHeight) + 2);
+            }
+        }
+        canvas.drawRoundRect(0, 0, width - 1, height - 1, 2, WHITE);
+        canvas.popClip();
     }
 
-    void BBB_i2c_oled::textBox(const std::string& text, int x, int y) {
+    void BBB_i2c_oled::drawTextBox(const TextRun& line, int x, int y) {
 
-        int y_end = y + 12;
-        int x_end = x + (text.length() * 6) + 2;
+        int height = line.height + 5;
+        int width = line.advance + 3;
 
-        this->display.drawText(text, x + 2, y + 2);
-        this->display.drawRectangle(x, y, x_end, y_end, WHITE);
+        SSD1306Canvas& canvas = this->display.getCanvas();
+        canvas.pushViewport(x, y, width, height);
+        canvas.drawRun(line, 2, 2);
+        canvas.drawRoundRect(0, 0, width - 1, height - 1, 2, WHITE);
+        canvas.popClip();
+    }
+
+    // Draws a PBM or PGM file, e.g. a splash screen or icon kept on the SD
+    // card. The file is mapped and only the visible part is decoded.
+    bool BBB_i2c_oled::image(const std::string& path, int x, int y) {
+
+        PnmImage file(path);
+
+        if(!file.isValid()) {
+            return false;
+        }
+        this->display.getCanvas().drawImage(file, x, y);
+        return true;
     }
 
     void BBB_i2c_oled::progressBarHrz(int x1, int y1, int x2, int y2, int color, int min, int max, int value) {
 
         if(value >= min && value <= max) {
                 
-            this->display.drawRectangle(x1, y1, x2, y2, color);
+            this->display.getCanvas().drawRectangle(x1, y1, x2, y2, color);
 
-            int progressEndPoint = mapRange(value, min, max, x1 + 2, x2 + 2);
+            int progressEndPoint = mapRange(value, min, max, x1 + 2, x2 - 2);
 
-            this->display.fillRectangle(x1 + 2, y1 + 2, progressEndPoint, y2 - 2, color);
+            this->display.getCanvas().fillRectangle(x1 + 2, y1 + 2, progressEndPoint, y2 - 2, color);
         }
     }
 
@@ -99,21 +185,74 @@ namespace BBB_sys {
 
         if(value >= min && value <= max) {
                 
-            this->display.drawRectangle(x1, y1, x2, y2, color);
+            this->display.getCanvas().drawRectangle(x1, y1, x2, y2, color);
 
-            int progressEndPoint = mapRange(value, min, max, y1 + 2, y2 + 2);
+            int progressEndPoint = mapRange(value, min, max, y1 + 2, y2 - 2);
 
-            this->display.fillRectangle(x1 + 2, y1 + 2, x2 - 2, progressEndPoint, color);
+            this->display.getCanvas().fillRectangle(x1 + 2, y1 + 2, x2 - 2, progressEndPoint, color);
         }
     }
 
+    // The update* widgets redraw over a cleared background and send only
+    // their own region, the rest of the frame is left as it is on the display
+
+    void BBB_i2c_oled::updateText(const std::string& text, int x, int y) {
+
+        int x_end = x + Font6x8::measure(text) - 1;
+
+        this->display.getCanvas().fillRectangle(x, y, x_end, y + 7, BLACK);
+        this->display.getCanvas().drawText(text, x, y);
+        this->display.updateRegion(x, y, x_end, y + 7);
+    }
+
+    void BBB_i2c_oled::updateTextBox(const std::vector<std::string>& text, int x, int y) {
+
+        int maxLineWidth = lookupLines(text);
+
+        int y_end = y + text.size() * this->font->getHeight() + 4;
+        int x_end = x + maxLineWidth + 2;
+
+        this->display.getCanvas().fillRectangle(x, y, x_end, y_end, BLACK);
+        drawTextBox(text, maxLineWidth, x, y);
+        this->display.updateRegion(x, y, x_end, y_end);
+    }
+
+    void BBB_i2c_oled::updateTextBox(const std::string& text, int x, int y) {
+
+        const TextRun& line = this->textCache.run(*this->font, text);
+
+        int y_end = y + line.height + 4;
+        int x_end = x + line.advance + 2;
+
+        this->display.getCanvas().fillRectangle(x, y, x_end, y_end, BLACK);
+        drawTextBox(line, x, y);
+        this->display.updateRegion(x, y, x_end, y_end);
+    }
+
+    void BBB_i2c_oled::updateProgressBarHrz(int x1, int y1, int x2, int y2, int color, int min, int max, int value) {
+
+        this->display.getCanvas().fillRectangle(x1, y1, x2, y2, !color);
+        progressBarHrz(x1, y1, x2, y2, color, min, max, value);
+        this->display.updateRegion(x1, y1, x2, y2);
+    }
+
+    void BBB_i2c_oled::updateProgressBarVrt(int x1, int y1, int x2, int y2, int color, int min, int max, int value) {
+
+        this->display.getCanvas().fillRectangle(x1, y1, x2, y2, !color);
+        progressBarVrt(x1, y1, x2, y2, color, min, max, value);
+        this->display.updateRegion(x1, y1, x2, y2);
+    }
+
     SSD1306* BBB_i2c_oled::getDisplay() {
 
         return &this->display;
     }
 
+    // Present the frame and start the next one from an empty buffer. With the
+    // flush thread running this only swaps buffers and the bus transfer
+    // overlaps drawing of the next frame.
     void BBB_i2c_oled::updateScreen() {
-        this->display.renderDisplay(0,7);
+        this->display.present();
         this->display.clearBuffer();
     }
 
@@ -126,31 +265,36 @@ namespace BBB_sys {
 
     void Menu::drawMenu(int x, int y) {
 
-        int rows = floor((63 - y)/14);
+        int rows = floor((SSD1306::HEIGHT - 1 - y)/14);
         int columns = (int)ceil((float)this->elements.size()/(float)rows);
 
-        if((127 - x < columns * 30)) {
+        if((SSD1306::WIDTH - 1 - x < columns * 30)) {
             std::cerr << "Too many menu elements to display" << std::endl;
             return;
         }
 
         int index = 0;
 
+        // Every element is confined to its 30 x 14 cell with the highlight
+        // frame one pixel outside the text box
+        SSD1306Canvas& canvas = this->OLED.getDisplay()->getCanvas();
+        canvas.pushViewport(x - 1, y - 1, SSD1306::WIDTH - x + 1, SSD1306::HEIGHT - y + 1);
+
         for(int colInd = 0; colInd < columns; colInd++) {
             for(int rowInd = 0; rowInd < rows; rowInd++) {
-                
-                int elem_coord_x = x + (colInd * 30);
-                int elem_coord_y = y + (rowInd * 14);
 
                 if(index < this->elements.size()) {
+                    canvas.pushViewport(colInd * 30, rowInd * 14, 30, 15);
                     if(index == this->activeElement) {
-                        this->OLED.getDisplay()->drawRectangle(elem_coord_x - 1, elem_coord_y - 1, elem_coord_x + 27, elem_coord_y + 13, WHITE);
+                        canvas.drawRoundRect(0, 0, 28, 14, 3, WHITE);
                     }
-                    this->OLED.textBox(this->elements[index], elem_coord_x, elem_coord_y);
+                    this->OLED.textBox(this->elements[index], 1, 1);
+                    canvas.popClip();
                 }
                 index++;
             }
         }
+        canvas.popClip();
     }
 
     void Menu::updateMenu(int x, int y) {
@@ -192,47 +336,48 @@ namespace BBB_sys {
     System::System(int i2c_bus) : OLED(i2c_bus), HTTPmessages(), main_menu(5,17,{"MESG", "STAT", "ITM1", "....", "....", "...."}, this->OLED) {
     }
 
+    System::System(Transport& transport) : OLED(transport), main_menu(5,17,{"MESG", "STAT", "ITM1", "....", "....", "...."}, this->OLED), HTTPmessages() {
+    }
+
     System::~System() {
-        this->OLED.~BBB_i2c_oled();
     }
 
     void System::init_frame() {
         
-        this->OLED.getDisplay()->drawRectangle(0,0,127,63,WHITE);
-        this->OLED.getDisplay()->drawText("BEAGLE sys",2,2);
-        this->OLED.getDisplay()->drawText(getCurrentTime(), 70, 2);
-
-        if(hasInternetConnection()) {
-
-            uint8_t connectedSymbol[] = {
-                0b00000000,
-                0b11100000,
-                0b00000000,
-                0b11111000,
-                0b11111000,
-                0b00000000,
-                0b11111111,
-                0b11111111
-            };
-            this->OLED.getDisplay()->draw_8(connectedSymbol, 8, 102, 2);
-        }
-        else {
-
-            uint8_t connectedSymbol[] = {
-                0b00000000,
-                0b00000101,
-                0b11000010,
-                0b00000101,
-                0b11110000,
-                0b00000000,
-                0b11111100,
-                0b00000000
-
-            };
-            this->OLED.getDisplay()->draw_8(connectedSymbol, 8, 102, 2);
-        }
+        const int right = SSD1306::WIDTH - 1;
+        const int bottom = SSD1306::HEIGHT - 1;
+
+        this->OLED.getDisplay()->getCanvas().drawRectangle(0,0,right,bottom,WHITE);
+        this->OLED.getDisplay()->getCanvas().drawText("BEAGLE sys",2,2);
+        this->OLED.getDisplay()->getCanvas().drawText(getCurrentTime(), right - 57, 2);
+
+        static const uint8_t connectedSymbol[] = {
+            0b00000000,
+            0b11100000,
+            0b00000000,
+            0b11111000,
+            0b11111000,
+            0b00000000,
+            0b11111111,
+            0b11111111
+        };
+        static const uint8_t disconnectedSymbol[] = {
+            0b00000000,
+            0b00000101,
+            0b11000010,
+            0b00000101,
+            0b11110000,
+            0b00000000,
+            0b11111100,
+            0b00000000
+        };
+        static const Bitmap connectedIcon(connectedSymbol, 8);
+        static const Bitmap disconnectedIcon(disconnectedSymbol, 8);
+
+        // Copied over whatever was there, so the icon can change without a clear
+        this->OLED.getDisplay()->getCanvas().blit(hasInternetConnection() ? connectedIcon : disconnectedIcon, right - 25, 2, ROP_COPY);
         
-        this->OLED.progressBarVrt(115, 5, 120, 58, WHITE, 0, 163, BBB_gpio::analogRead(0) * 100);
+        this->OLED.progressBarVrt(right - 12, 5, right - 7, bottom - 5, WHITE, 0, 163, BBB_gpio::analogRead(0) * 100);
     }
 
     void System::start_HTTP_server() {
@@ -277,6 +422,8 @@ namespace BBB_sys {
         std::thread HTTP_server_thread(&System::start_HTTP_server, this);
 
         HTTP_server_thread.detach();
+
+        this->OLED.getDisplay()->startFlushThread();
     }
 
     std::vector<std::string>& System::getHTTPmessages() {
@@ -300,6 +447,21 @@ namespace BBB_sys {
         this->OLED.updateScreen();
     }
 
+    // Refresh only the clock of the status bar
+    void System::updateClock() {
+
+        this->OLED.updateText(getCurrentTime(), SSD1306::WIDTH - 58, 2);
+    }
+
+    // Refresh only the ADC gauge, cheap enough to run at the sampling rate
+    void System::updateGauge() {
+
+        const int right = SSD1306::WIDTH - 1;
+        const int bottom = SSD1306::HEIGHT - 1;
+
+        this->OLED.updateProgressBarVrt(right - 12, 5, right - 7, bottom - 5, WHITE, 0, 163, BBB_gpio::analogRead(0) * 100);
+    }
+
     void System::checkMessages() {
 
         this->OLED.getDisplay()->clearBuffer();
@@ -5,54 +5,76 @@
 #include "SSD1306.h"
 
 // Constructor to initialize the i2c bus
-SSD1306::SSD1306(const int bus) : bus(bus), file(-1), cursor{0,0,0} {}
+template<class Layout>
+SSD1306Driver<Layout>::SSD1306Driver(const int bus) : bus(bus), ownedTransport(new I2CTransport(bus, I2C_SLAVE_ADDR)), transport(ownedTransport.get()),
+    cursor{0,0,0}, frames(), back(&frames[0]), pending(&frames[1]), front(&frames[2]),
+    shadow(), shadowPages(0x00), scrollPage(0), orientation(ORIENT_NORMAL), patchCount(0),
+    online(true), lastError(0), backoffMs(RECOVERY_BACKOFF_MIN_MS), retryAt(), flushRunning(false), pendingReady(false), stats{0, 0, 0, 0, 0, 0, 0} {
 
-// Destructor to close the file descriptor if open
-SSD1306::~SSD1306() {
-    if (this->file >= 0) {
-        close(this->file);
-    }
+    invalidateDisplay();
 }
 
-// Initialize the SSD1306 display
-bool SSD1306::begin() {
+// Constructor for a display behind any transport (i2c, SPI or the emulator)
+template<class Layout>
+SSD1306Driver<Layout>::SSD1306Driver(Transport& transport) : bus(-1), ownedTransport(), transport(&transport),
+    cursor{0,0,0}, frames(), back(&frames[0]), pending(&frames[1]), front(&frames[2]),
+    shadow(), shadowPages(0x00), scrollPage(0), orientation(ORIENT_NORMAL), patchCount(0),
+    online(true), lastError(0), backoffMs(RECOVERY_BACKOFF_MIN_MS), retryAt(), flushRunning(false), pendingReady(false), stats{0, 0, 0, 0, 0, 0, 0} {
 
-    // Open the device file of specified i2c bus
-    char file_path[20];
-    snprintf(file_path, 19, "/dev/i2c-%d", bus);
-    this->file = open(file_path, O_RDWR);
+    invalidateDisplay();
+}
 
-    if(this->file < 0) {
-        std::cerr << "Failed to open the i2c bus" << std::endl;
-        return false;
-    }
+// Destructor, the transport closes the file descriptor if open
+template<class Layout>
+SSD1306Driver<Layout>::~SSD1306Driver() {
+    stopFlushThread();
+}
 
-    std::cout << "File opened: " << file << std::endl;
-    
-    // Tell i2c driver the file descriptor is used to communicate with the device at I2C_SLAVE_ADDR
-    if(ioctl(this->file, I2C_SLAVE, I2C_SLAVE_ADDR) < 0) {
-    	std::cerr << "Failed to open /dev/i2c-" << bus << std::endl;
-	close(this->file);
+// Initialize the SSD1306 display
+template<class Layout>
+bool SSD1306Driver<Layout>::begin() {
+
+    // Open the device file of specified bus, every i2c message is addressed to I2C_SLAVE_ADDR
+    if(!this->transport->isOpen() && !this->transport->open()) {
+        std::cerr << "Failed to open the display transport (bus " << bus << ")" << std::endl;
+        return false;
     }
 
     initDisplay();
     clearDisplay();
-    return true;
+    return isOnline();
 }
 
 // Initialize the SSD1306 display with standard configuration
-void SSD1306::initDisplay() {
-    static const uint8_t init_sequence[] = {
+template<class Layout>
+void SSD1306Driver<Layout>::initDisplay() {
+
+    {
+        std::lock_guard<std::mutex> lock(this->busMutex);
+
+        if(!sendInit()) {
+            std::cerr << "Display init failed: (" << this->lastError << ") " << strerror(this->lastError) << " while writing" << std::endl;
+        }
+    }
+
+    // GRAM content is undefined after init, next render has to send everything
+    invalidateDisplay();
+}
+
+// Sends the init sequence, busMutex has to be held
+template<class Layout>
+bool SSD1306Driver<Layout>::sendInit() {
+    const uint8_t init_sequence[] = {
         DISP_OFF,
         SET_DISP_CLK, DISPCLK_DIV,
-        SET_MULTIPLEX, MULTIPLEX_64,
+        SET_MULTIPLEX, Panel::MULTIPLEX,
         SET_DISP_OFFSET, DISP_OFFSET,
         SET_DISP_START_LN,
         SET_CHARGE_PUMP, ENABLE_CH_PUMP,
         SET_MEM_ADD_MODE, HOR_MEM_ADD_MODE,     // Set memory addressing mode to horizontal
-        SET_SEG_REMAP,           // Set segment re-map 0 to 127
-        SET_COM_OUTPUT_SC_DIR,           // Set COM output scan direction
-        SET_COM_PINS, CONFIG_COM_PINS,     // Set Com pins hardware configuration
+        segRemap(),           // Set segment re-map, 127 to 0 when mirrored
+        comScanDir(),           // Set COM output scan direction
+        SET_COM_PINS, Panel::COM_PINS,    // Set Com pins hardware configuration
         SET_DISP_CONTRAST, CONTRAST_LEVEL,     // Set contrast control
         SET_PRE_CH_PRD, CONFIG_PRE_CH_PRD,     // Set pre-charge period
         SET_PX_TURNOFF_V, PX_TURNOFF_V,     // Set VCOMh Deselect level
@@ -61,306 +83,784 @@ void SSD1306::initDisplay() {
         DISP_ON            // Display on
     };
 
-    int init_bytes = sendCommand(init_sequence, sizeof(init_sequence));
+    this->transport->queueCommand(init_sequence, sizeof(init_sequence));
 
-    if(init_bytes != (sizeof(init_sequence) + 1)) {
-        std::cerr << "Display init failed: (" << init_bytes << ") " << strerror(errno) << " while writing" << std::endl;
-    };
+    int status = this->transport->flush();
+    if(status < 0) {
+        busFailed(-status);
+        return false;
+    }
+    this->online = true;
+    return true;
 }
 
-void SSD1306::setDisplayState(bool is_on) {
+template<class Layout>
+void SSD1306Driver<Layout>::setDisplayState(bool is_on) {
     const uint8_t command = is_on ? 0xAF : 0xAE;
     sendCommand(&command, 1);
 }
 
-void SSD1306::reset() {
+template<class Layout>
+void SSD1306Driver<Layout>::reset() {
     initDisplay();
     clearDisplay();
 }
 
-void SSD1306::clearBuffer() {
+template<class Layout>
+void SSD1306Driver<Layout>::clearBuffer() {
+
+    this->back->clear();
+    forgetSprites();
+}
+
+// Forget what the display GRAM holds so the next render sends every page,
+// starting over from the unscrolled page mapping
+template<class Layout>
+void SSD1306Driver<Layout>::invalidateDisplay() {
+
+    std::lock_guard<std::mutex> lock(this->busMutex);
+    this->shadowPages = 0x00;
+    this->scrollPage = 0;
+    this->back->markDirty(0, WIDTH - 1, ~0ULL);
+}
+
+// The frame the drawing functions write to
+template<class Layout>
+const Layout& SSD1306Driver<Layout>::getFrame() const {
+    return this->back->getBuffer();
+}
 
-    std::memset(frameBuffer, 0x00, sizeof(frameBuffer));
+// The canvas to draw the next frame on. With the flush thread running it
+// changes with every present(), so it has to be fetched again afterwards.
+template<class Layout>
+Canvas<Layout>& SSD1306Driver<Layout>::getCanvas() {
+    return *this->back;
 }
 
-void SSD1306::clearDisplay() {
+template<class Layout>
+void SSD1306Driver<Layout>::clearDisplay() {
 
     clearBuffer();
-    renderDisplay(0,7);
+    renderFrame();
 }
 
 // Sets the cursor position for the next write operation
-int SSD1306::setCursor(uint8_t col, uint8_t page) {
+template<class Layout>
+int SSD1306Driver<Layout>::setCursor(uint8_t col, uint8_t page) {
 
         this->cursor[0] = static_cast<uint8_t>(0xB0 + page);                 // Set page start address
         this->cursor[1] = static_cast<uint8_t>(0x00 + (col & 0x0F));          // Lower column start address
         this->cursor[2] = static_cast<uint8_t>(0x10 + ((col >> 4 ) & 0x0F));  // Higher column start addres
     
-    return write(file, cursor, sizeof(cursor));
+    return (sendCommand(cursor, sizeof(cursor)) == sizeof(cursor) + 1) ? sizeof(cursor) : -1;
 }
 
-// Send commands to the display
-int SSD1306::sendCommand(const uint8_t *commands, size_t len) {
+// Send commands to the display, returns the bytes written including the control byte or errno
+template<class Layout>
+int SSD1306Driver<Layout>::sendCommand(const uint8_t *commands, size_t len) {
 
-    uint8_t com_buffer[len + 1];                    // +1 for the control byte
+    std::lock_guard<std::mutex> lock(this->busMutex);
 
-    com_buffer[0] = 0x00;                           // 0x00 is the control byte for commands
+    if(!busReady()) {
+        return this->lastError;
+    }
+    this->transport->queueCommand(commands, len);
+    return flushTransport();
+}
+
+// Queue commands to be sent with the next flushCommands() in the same bus transaction batch
+template<class Layout>
+void SSD1306Driver<Layout>::queueCommand(const uint8_t *commands, size_t len) {
+
+    std::lock_guard<std::mutex> lock(this->busMutex);
+    this->transport->queueCommand(commands, len);
+}
 
-    std::memcpy(com_buffer + 1, commands, len);     // std::memcpy to copy the commands into the buffer after the control byte
+// Send all queued messages with a single I2C_RDWR call, returns the bytes written or errno
+template<class Layout>
+int SSD1306Driver<Layout>::flushCommands() {
 
-    int debug = write(file, com_buffer, len + 1);   // Write the buffer to the i2c bus
+    std::lock_guard<std::mutex> lock(this->busMutex);
 
-    if(debug != (len + 1)) {
-        std::cerr << "Failed to send i2c command:\n" <<
-        debug << " out of " << len + 1 << " bytes written succesfully.\n" <<
-        "Error: (" << errno << ") " << strerror(errno) << std::endl;
-        return errno;
+    if(!busReady()) {
+        return this->lastError;
+    }
+    return flushTransport();
+}
+
+// Flushes the transport and handles failures, busMutex has to be held
+template<class Layout>
+int SSD1306Driver<Layout>::flushTransport() {
+
+    int debug = this->transport->flush();
+
+    if(debug < 0) {
+        busFailed(-debug);
+        return -debug;
     }
     return debug;
 }
 
-void SSD1306::inverseDisplay(bool is_inverse) {
+// Returns true when the display can be written to. While it is offline
+// nothing goes on the bus until the retry time, then the display is probed
+// and, if it answers, initialized again with every page marked for a
+// resend. Messages queued while offline are dropped. busMutex has to be held.
+template<class Layout>
+bool SSD1306Driver<Layout>::busReady() {
+
+    if(this->online) {
+        return true;
+    }
+    this->transport->discard();
+
+    if(std::chrono::steady_clock::now() < this->retryAt) {
+        this->stats.offlineSkips++;
+        return false;
+    }
+
+    this->stats.probes++;
+    int status = this->transport->probe();
+
+    if(status < 0) {
+        busFailed(-status);
+        return false;
+    }
+    if(!sendInit()) {
+        return false;
+    }
+
+    this->shadowPages = 0x00;
+    this->scrollPage = 0;
+    this->stats.recoveries++;
+    std::cerr << "Display is back, re-initialized" << std::endl;
+    return true;
+}
+
+// Takes the display offline after a failed transfer and schedules the next
+// probe. Only the first failure is reported, the retry interval doubles with
+// every one after it. busMutex has to be held.
+template<class Layout>
+void SSD1306Driver<Layout>::busFailed(int error) {
+
+    this->lastError = error;
+    this->shadowPages = 0x00;
+    this->stats.busErrors++;
+
+    if(this->online) {
+        std::cerr << "Display not responding: (" << error << ") " << strerror(error) << ", retrying in the background" << std::endl;
+        this->online = false;
+        this->backoffMs = RECOVERY_BACKOFF_MIN_MS;
+    }
+    else {
+        this->backoffMs = std::min(this->backoffMs * 2, RECOVERY_BACKOFF_MAX_MS);
+    }
+    this->retryAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(this->backoffMs);
+}
+
+template<class Layout>
+bool SSD1306Driver<Layout>::isOnline() {
+    std::lock_guard<std::mutex> lock(this->busMutex);
+    return this->online;
+}
+
+template<class Layout>
+void SSD1306Driver<Layout>::inverseDisplay(bool is_inverse) {
     const uint8_t command = is_inverse ?  SET_DISP_INVERSE : SET_DISP_NORM;
     sendCommand(&command, 1);
 }
 
-void SSD1306::drawText(const std::string& text, int x, int y) {
+// Mirrors or turns the picture with the controller's scan directions, the
+// frame is drawn and sent the same way. The GRAM keeps its content unless a
+// panel narrower than the GRAM moves to the columns at its other end, then
+// the next render sends every page. Kept over re-initialization.
+template<class Layout>
+void SSD1306Driver<Layout>::setOrientation(Orientation orientation) {
 
-    // check if cursor coordinates are valid
-    if((x < 0 || x > 127) || (y < 0 || y > 55)) {
-        std::cout << "Cursor index error" << std::endl;
+    std::lock_guard<std::mutex> lock(this->busMutex);
+
+    const int offset = columnOffset();
+    this->orientation = orientation;
+
+    if(columnOffset() != offset) {
+        this->shadowPages = 0x00;
     }
-    else {
 
-        int x_cursor = x;
+    if(!busReady()) {
+        return;
+    }
+    const uint8_t commands[] = { segRemap(), comScanDir() };
+    this->transport->queueCommand(commands, sizeof(commands));
+    flushTransport();
+}
 
-        for(char c : text){
-            uint8_t charMap[8];    
-            uint8_t* charMapPtr = ASCIImap(c);
+template<class Layout>
+Orientation SSD1306Driver<Layout>::getOrientation() {
+    std::lock_guard<std::mutex> lock(this->busMutex);
+    return this->orientation;
+}
 
-            for(int i = 0; i < 8; i++) {
-                charMap[i] = *(charMapPtr + i);    
-            }
-            draw_8(charMap, 8, x_cursor, y);
-            x_cursor += 6;
-        }
+// Column address 0 drives SEG127 by default (0xA1), mirrored it drives SEG0
+template<class Layout>
+uint8_t SSD1306Driver<Layout>::segRemap() const {
+    return (this->orientation & ORIENT_MIRROR_X) ? SET_SEG_NO_REMAP : SET_SEG_REMAP;
+}
+
+template<class Layout>
+uint8_t SSD1306Driver<Layout>::comScanDir() const {
+    return (this->orientation & ORIENT_MIRROR_Y) ? SET_COM_OUTPUT_NORMAL : SET_COM_OUTPUT_SC_DIR;
+}
+
+// First GRAM column of the window, the panel is wired to the same segments
+// whichever way they are scanned
+template<class Layout>
+int SSD1306Driver<Layout>::columnOffset() const {
+    return (this->orientation & ORIENT_MIRROR_X) ? GRAM_COLUMNS - Panel::WIDTH - Panel::COLUMN_OFFSET : Panel::COLUMN_OFFSET;
+}
+
+// Registers a sprite and returns its id, it is drawn by the first moveSprite().
+// XOR sprites are erased by drawing them again and keep what is under them,
+// the others clear their rectangle (set it for ROP_AND_NOT) when they move.
+template<class Layout>
+int SSD1306Driver<Layout>::addSprite(const Bitmap& bitmap, RasterOp op) {
+
+    this->sprites.emplace_back(bitmap, op);
+    return static_cast<int>(this->sprites.size()) - 1;
+}
+
+// Erases the sprite at its old position and draws it at the new one, only
+// the columns of the two footprints are touched and marked dirty
+template<class Layout>
+void SSD1306Driver<Layout>::moveSprite(int id, int x, int y) {
+
+    if(id < 0 || id >= static_cast<int>(this->sprites.size())) {
+        std::cout << "Sprite index error : " << id << std::endl;
+        return;
     }
+    this->back->moveSprite(this->sprites[id], x, y);
 }
 
-void SSD1306::draw_8(uint8_t* bitmap, size_t width, int x, int y) {
+template<class Layout>
+void SSD1306Driver<Layout>::hideSprite(int id) {
 
-    int x_end = x + static_cast<int>(width);
-    int bitmap_ind = 0;
-    if((x < 0 || x > 127) || (y < 0 && y > 55)) {
-        std::cout << "Draw_8: Cursor index error" << std::endl;
+    if(id < 0 || id >= static_cast<int>(this->sprites.size())) {
+        std::cout << "Sprite index error : " << id << std::endl;
+        return;
     }
-    else {
-        for(int col = x; col < x_end; col++) {
-            if(col < 128) {
-                frameBuffer[col] |= ((static_cast<uint64_t>(bitmap[bitmap_ind])) << y);
-                bitmap_ind++;
-            }
+    this->back->hideSprite(this->sprites[id]);
+}
+
+// The back buffer no longer holds the sprites, the next move only draws them
+template<class Layout>
+void SSD1306Driver<Layout>::forgetSprites() {
+
+    for(Sprite& sprite : this->sprites) {
+        sprite.setVisible(false);
+    }
+}
+
+// Queues the column and page address window followed by its content. In
+// horizontal addressing mode the GRAM pointer wraps from the last column of
+// the window to the first column of the next page by itself, so the window
+// can be streamed as one message or, for zero-copy layouts, as one message
+// per page taken straight from the buffer. The shadow copy is updated
+// optimistically and invalidated if the batch fails. Columns and pages are
+// those of the panel, the pages logical: a window that wraps past the last
+// GRAM page is split in two.
+template<class Layout>
+void SSD1306Driver<Layout>::queueWindow(FrameSlot* slot, int col0, int col1, int page0, int page1) {
+
+    const int gramPage0 = (page0 + this->scrollPage) % GRAM_PAGES;
+
+    if(gramPage0 + (page1 - page0) >= GRAM_PAGES) {
+        const int split = page0 + (GRAM_PAGES - 1 - gramPage0);
+        queueWindow(slot, col0, col1, page0, split);
+        queueWindow(slot, col0, col1, split + 1, page1);
+        return;
+    }
+
+    // Start line is unknown after init or a failed batch, it goes out with the first window
+    if(this->shadowPages == 0x00) {
+        const uint8_t start_line = static_cast<uint8_t>(SET_DISP_START_LN | (this->scrollPage * 8));
+        this->transport->queueCommand(&start_line, 1);
+    }
+
+    const uint8_t commands[] = {
+        0x21, static_cast<uint8_t>(col0 + columnOffset()),          // Column start and end address
+        static_cast<uint8_t>(col1 + columnOffset()),
+        0x22, static_cast<uint8_t>(gramPage0),                              // Page start and end address
+        static_cast<uint8_t>(gramPage0 + (page1 - page0))
+    };
+    this->transport->queueCommand(commands, sizeof(commands));
+
+    const int width = col1 - col0 + 1;
+
+    uint8_t* data = Layout::ZERO_COPY ? nullptr : this->transport->reserveData(width * (page1 - page0 + 1));
+
+    for(int page = page0; page <= page1; page++) {
+
+        if(Layout::ZERO_COPY) {
+            // The byte in front of the window is borrowed for the control byte
+            // and restored by restorePatches() once the batch is sent
+            uint8_t* message = slot->buffer.pageMessage(page, col0);
+            this->patches[this->patchCount].at = message;
+            this->patches[this->patchCount].saved = *message;
+            this->patchCount++;
+            *message = CTRL_DATA;
+            this->transport->queueMessage(message, width + 1);
+            data = message + 1;
+        }
+        else {
+            Map::pageRow(slot->buffer, page, col0, col1, data);
+        }
+
+        for(int col = col0; col <= col1; col++) {
+            this->shadow.setPageByte(page, col, data[col - col0]);
+        }
+        data += width;
+
+        // A page is known once all of its columns have been written
+        if(col0 == 0 && col1 == Panel::WIDTH - 1) {
+            this->shadowPages |= (1 << page);
         }
     }
 }
 
-void SSD1306::drawPixel(int x, int y, int color) {
+// Puts back the bytes borrowed for control bytes by zero-copy windows
+template<class Layout>
+void SSD1306Driver<Layout>::restorePatches() {
+
+    while(this->patchCount > 0) {
+        this->patchCount--;
+        *this->patches[this->patchCount].at = this->patches[this->patchCount].saved;
+    }
+}
+
+// Sends the queued windows in a single I2C_RDWR call, busMutex has to be held
+template<class Layout>
+bool SSD1306Driver<Layout>::flushWindows() {
+
+    int status = this->transport->flush();
+    restorePatches();
+
+    if(status < 0) {
+        busFailed(-status);
+        return false;
+    }
+    return true;
+}
+
+// Sends one address window and its content, busMutex has to be held
+template<class Layout>
+bool SSD1306Driver<Layout>::writeWindow(FrameSlot* slot, int col0, int col1, int page0, int page1) {
+
+    if(!busReady()) {
+        return false;
+    }
+    queueWindow(slot, col0, col1, page0, page1);
+    return flushWindows();
+}
+
+// Sends the whole frame buffer with one window command and one data transaction
+template<class Layout>
+void SSD1306Driver<Layout>::renderFrame() {
+
+    renderWindow(0, Panel::WIDTH - 1, 0, Panel::PAGES - 1);
+}
 
-    if((x < 0 || x > 127) || (y < 0 || y > 63)) {
+// Sends a rectangular column/page window of the back buffer regardless of the
+// dirty state. The window is in panel columns and pages, which for a
+// QuarterTurn layout cross the frame pages, so there only a window of the
+// whole panel leaves the frame clean.
+template<class Layout>
+void SSD1306Driver<Layout>::renderWindow(int col0, int col1, int page0, int page1) {
+
+    col0 = std::max(col0, 0);
+    col1 = std::min(col1, Panel::WIDTH - 1);
+    page0 = std::max(page0, 0);
+    page1 = std::min(page1, Panel::PAGES - 1);
+
+    if(col0 > col1 || page0 > page1) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->busMutex);
+
+    if(!writeWindow(this->back, col0, col1, page0, page1)) {
+        return;
+    }
+    if(Map::TRANSPOSED) {
+        if(col0 == 0 && col1 == Panel::WIDTH - 1 && page0 == 0 && page1 == Panel::PAGES - 1) {
+            this->back->clearDirty();
+        }
         return;
     }
-    color ? (this->frameBuffer[x] |= (1ULL << y)) : (this->frameBuffer[x] &= ~(1ULL << y));
+    for(int page = page0; page <= page1; page++) {
+        if(col0 <= this->back->dirtyStart[page] && this->back->dirtyEnd[page] <= col1) {
+            this->back->dirtyStart[page] = WIDTH;
+            this->back->dirtyEnd[page] = -1;
+        }
+    }
 }
 
-// Usign Bresenham's line algorithm
-void SSD1306::drawLine(int x0, int y0, int x1, int y1, int width, int color) {
-    bool steep = abs(y1 - y0) > abs(x1 - x0); // Check if the line is steep
-    if (steep) {
-        // Swap x and y for steep lines
-        std::swap(x0, y0);
-        std::swap(x1, y1);
+// Sends a rectangle of pixels, rounded out to whole panel pages, to the
+// display. The window is narrowed to the columns that differ from the GRAM,
+// so a widget flushes only what changed since it was last shown. With the
+// flush thread running the rectangle goes into the pending frame instead,
+// a frame the thread sends later can't cover it with older pixels.
+template<class Layout>
+void SSD1306Driver<Layout>::updateRegion(int x0, int y0, int x1, int y1) {
+
+    if(x0 > x1) std::swap(x0, x1);
+    if(y0 > y1) std::swap(y0, y1);
+
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, WIDTH - 1);
+    y0 = std::max(y0, 0);
+    y1 = std::min(y1, HEIGHT - 1);
+
+    if(x0 > x1 || y0 > y1) {
+        return;
     }
-    if (x0 > x1) {
-        // Ensure we're always drawing from left to right
-        std::swap(x0, x1);
-        std::swap(y0, y1);
+
+    if(isFlushThreadRunning()) {
+        presentRegion(x0, y0, x1, y1);
+        return;
+    }
+
+    // The rectangle on the panel
+    int panelX0 = x0, panelY0 = y0, panelX1 = x1, panelY1 = y1;
+    Map::rect(panelX0, panelY0, panelX1, panelY1);
+
+    const int page0 = panelY0 >> 3;
+    const int page1 = panelY1 >> 3;
+    int col0 = Panel::WIDTH, col1 = -1;
+
+    std::lock_guard<std::mutex> lock(this->busMutex);
+
+    if(!busReady()) {
+        return;
     }
 
-    int dx = x1 - x0;
-    int dy = abs(y1 - y0);
-    int error = dx / 2;
-    int yStep = (y0 < y1) ? 1 : -1;
-    int y = y0;
+    for(int page = page0; page <= page1; page++) {
+
+        int start = panelX0, end = panelX1;
 
-    for (int x = x0; x <= x1; x++) {
-        // Draw the pixel, reversing the swap for steep lines
-        if (steep) {
-            for (int i = 0; i < width; i++) {
-                drawPixel(y + i, x, color); // Swap back x and y
+        if(this->shadowPages & (1 << page)) {
+            while(start <= end && Map::pageByte(this->back->buffer, page, start) == this->shadow.pageByte(page, start)) {
+                start++;
             }
-        } else {
-            for (int i = 0; i < width; i++) {
-                drawPixel(x, y + i, color);
+            while(end >= start && Map::pageByte(this->back->buffer, page, end) == this->shadow.pageByte(page, end)) {
+                end--;
             }
         }
+        if(start <= end) {
+            col0 = std::min(col0, start);
+            col1 = std::max(col1, end);
+        }
+    }
+
+    if(col0 <= col1 && !writeWindow(this->back, col0, col1, page0, page1)) {
+        return;
+    }
+
+    // Frame pages the panel window covered completely are clean now, turned
+    // frames get their rows sent exactly and their columns rounded out
+    const int clean0 = Map::TRANSPOSED ? (y0 + 7) >> 3 : y0 >> 3;
+    const int clean1 = Map::TRANSPOSED ? ((y1 + 1) >> 3) - 1 : y1 >> 3;
 
-        error -= dy;
-        if (error < 0) {
-            y += yStep;
-            error += dx;
+    for(int page = clean0; page <= clean1; page++) {
+        if(x0 <= this->back->dirtyStart[page] && this->back->dirtyEnd[page] <= x1) {
+            this->back->dirtyStart[page] = WIDTH;
+            this->back->dirtyEnd[page] = -1;
         }
     }
 }
 
-void SSD1306::drawHrzLine(int x0, int x1, int y, int color) {
+// Copies a frame rectangle of the back buffer into the pending frame and
+// wakes up the flush thread. The rectangle is rounded out to the panel pages
+// updateRegion() would send, the pending frame then holds the latest
+// presented frame with the region on top.
+template<class Layout>
+void SSD1306Driver<Layout>::presentRegion(int x0, int y0, int x1, int y1) {
+
+    // Frame pages the region covers completely, as updateRegion() cleans them
+    const int clean0 = Map::TRANSPOSED ? (y0 + 7) >> 3 : y0 >> 3;
+    const int clean1 = Map::TRANSPOSED ? ((y1 + 1) >> 3) - 1 : y1 >> 3;
+
+    // Panel pages are frame rows, or frame columns for a turned frame
+    if(Map::TRANSPOSED) {
+        x0 &= ~7;
+        x1 |= 7;
+    }
+    else {
+        y0 &= ~7;
+        y1 |= 7;
+    }
+    const uint64_t rows = FrameSlot::panelRows(y0, y1);
 
-    if (y < 0 || y > 63) return;
+    {
+        std::lock_guard<std::mutex> lock(this->frameMutex);
 
-    int start_x = x0, end_x = x1;
+        for(int col = x0; col <= x1; col++) {
+            this->pending->buffer.setColumn(col, (this->pending->buffer.column(col) & ~rows) | (this->back->buffer.column(col) & rows));
+        }
+        this->pending->markDirty(x0, x1, rows);
 
-    if(x0 > x1) {
-        start_x = x1;
-        end_x = x0;
+        if(!this->pendingReady) {
+            this->pendingReady = true;
+            this->stats.framesPresented++;
+        }
     }
-    for(int i = start_x; i <= end_x; i++) {
-        drawPixel(i, y, color);
+    this->frameReady.notify_one();
+
+    // The region is handed over, its dirty spans in the back buffer are done
+    for(int page = clean0; page <= clean1; page++) {
+        if(x0 <= this->back->dirtyStart[page] && this->back->dirtyEnd[page] <= x1) {
+            this->back->dirtyStart[page] = WIDTH;
+            this->back->dirtyEnd[page] = -1;
+        }
     }
 }
 
-void SSD1306::drawVertLine(int y0, int y1, int x, int color) {
+// Sends the changed part of each page in [startPage, endPage] to the display.
+// With the flush thread running the frame is presented instead and the back
+// buffer keeps its content, so callers can go on drawing on top of it.
+template<class Layout>
+void SSD1306Driver<Layout>::renderDisplay(int startPage, int endPage) {
+
+    if(isFlushThreadRunning()) {
+        swapBack(true);
+        return;
+    }
 
-    if (x < 0 || x > 127) return;
+    std::lock_guard<std::mutex> lock(this->busMutex);
+    renderSlot(this->back, startPage, endPage);
+}
 
-    int start_y = y0, end_y = y1;
+// Dirty spans recorded by the drawing functions are trimmed against the shadow
+// copy of the GRAM so only columns that really differ go over the bus. The
+// spans go out as one bounding window when that is cheaper than a window per
+// page. busMutex has to be held.
+template<class Layout>
+void SSD1306Driver<Layout>::renderSlot(FrameSlot* slot, int startPage, int endPage) {
 
-    if(y0 > y1) {
-        start_y = y1;
-        end_y = y0;
-    }
-    for(int i = start_y; i <= end_y; i++) {
-        drawPixel(x, i, color);
+    if(busReady() && queueSlot(slot, startPage, endPage)) {
+        flushWindows();
     }
 }
 
-void SSD1306::drawRectangle(int x0, int y0, int x1, int y1, int color) {
-    drawHrzLine(x0, x1, y0, color);
-    drawHrzLine(x0, x1, y1, color);
-    drawVertLine(y0, y1, x0, color);
-    drawVertLine(y0, y1, x1, color);
-}
+// Queues the windows renderSlot() sends, returns false when nothing changed
+template<class Layout>
+bool SSD1306Driver<Layout>::queueSlot(FrameSlot* slot, int startPage, int endPage) {
 
-void SSD1306::fillRectangle(int x0, int y0, int x1, int y1, int color) {
-    
-    for(int i = y0; i <= y1; i++) {
-        drawHrzLine(x0, x1, i, color);
+    if(startPage < 0) startPage = 0;
+    if(endPage > PAGES - 1) endPage = PAGES - 1;
+
+    // Dirty spans of the frame pages in range, taken over as panel page spans
+    int dirtyStart[PAGES];
+    int dirtyEnd[PAGES];
+
+    for(int page = 0; page < PAGES; page++) {
+        if(page < startPage || page > endPage) {
+            dirtyStart[page] = WIDTH;
+            dirtyEnd[page] = -1;
+            continue;
+        }
+        dirtyStart[page] = slot->dirtyStart[page];
+        dirtyEnd[page] = slot->dirtyEnd[page];
+        slot->dirtyStart[page] = WIDTH;
+        slot->dirtyEnd[page] = -1;
     }
-}
 
-void SSD1306::drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, int width, int color) {
+    int spanStart[Panel::PAGES];
+    int spanEnd[Panel::PAGES];
+    Map::spans(dirtyStart, dirtyEnd, spanStart, spanEnd);
 
-drawLine(x0, y0, x1, y1, width, color);
-drawLine(x0, y0, x2, y2, width, color);
-drawLine(x1, y1, x2, y2, width, color);
-}
+    // Every frame page of a turned frame crosses all panel pages
+    const int firstPage = Map::TRANSPOSED ? 0 : startPage;
+    const int lastPage = Map::TRANSPOSED ? Panel::PAGES - 1 : endPage;
+
+    int boxCol0 = Panel::WIDTH, boxCol1 = -1, boxPage0 = Panel::PAGES, boxPage1 = -1;
+    int pageBytes = 0;
+
+    for(int page = firstPage; page <= lastPage; page++) {
 
-void SSD1306::drawEqTriangle(int tipX, int tipY, int height, int width, int color) {
+        int col0 = spanStart[page];
+        int col1 = spanEnd[page];
 
-    int left_x = tipX - floor((1732*height/2000));
+        if(!(this->shadowPages & (1 << page))) {
+            col0 = 0;
+            col1 = Panel::WIDTH - 1;
+        }
+        else {
+            while(col0 <= col1 && Map::pageByte(slot->buffer, page, col0) == this->shadow.pageByte(page, col0)) {
+                col0++;
+            }
+            while(col1 >= col0 && Map::pageByte(slot->buffer, page, col1) == this->shadow.pageByte(page, col1)) {
+                col1--;
+            }
+        }
+
+        spanStart[page] = col0;
+        spanEnd[page] = col1;
+
+        if(col0 <= col1) {
+            boxCol0 = std::min(boxCol0, col0);
+            boxCol1 = std::max(boxCol1, col1);
+            boxPage0 = std::min(boxPage0, page);
+            boxPage1 = page;
+            pageBytes += (col1 - col0 + 1) + WINDOW_OVERHEAD;
+        }
+    }
+
+    if(boxCol0 > boxCol1) {
+        return false;
+    }
+
+    int boxBytes = (boxCol1 - boxCol0 + 1) * (boxPage1 - boxPage0 + 1) + WINDOW_OVERHEAD;
+
+    if(boxBytes <= pageBytes) {
+        queueWindow(slot, boxCol0, boxCol1, boxPage0, boxPage1);
+        return true;
+    }
 
-    int right_x = tipX + floor((1732*height/2000));
+    // Every page window goes out in the same I2C_RDWR batch
+    for(int page = boxPage0; page <= boxPage1; page++) {
+        if(spanStart[page] <= spanEnd[page]) {
+            queueWindow(slot, spanStart[page], spanEnd[page], page, page);
+        }
+    }
+    return true;
+}
 
-    int base_y = tipY + height;
+// Hands the back buffer to the display. Without the flush thread the frame is
+// rendered right away. With it the back buffer is swapped with the pending
+// one and the flush thread is woken up; a pending frame the thread has not
+// taken yet is dropped, only its dirty spans carry over. After the swap the
+// back buffer holds an older frame and has to be redrawn (clearBuffer()).
+template<class Layout>
+void SSD1306Driver<Layout>::present() {
+
+    if(!isFlushThreadRunning()) {
+        std::lock_guard<std::mutex> lock(this->busMutex);
+        renderSlot(this->back, 0, PAGES - 1);
+        return;
+    }
 
-    drawLine(tipX, tipY, left_x, base_y, width, color);
-    drawLine(tipX, tipY, right_x, base_y, width, color);
-    drawLine(left_x, base_y, right_x, base_y, width, color);
+    swapBack(false);
+
+    this->back->clearDirty();
+    this->back->markDirty(0, WIDTH - 1, ~0ULL);
+    forgetSprites();
 }
 
-void SSD1306::drawCircle(int x, int y, int radius, int color) {
+// Swaps the back canvas with the pending one and wakes up the flush thread.
+// With keepFrame the new back canvas starts as a copy of the presented one.
+// The copy is made before the flush thread can take the presented frame, a
+// zero-copy window borrows bytes of its buffer for control bytes while sent.
+template<class Layout>
+void SSD1306Driver<Layout>::swapBack(bool keepFrame) {
 
-    float dp;
-    int x1,y1;
-    x1 = 0;
-    y1 = radius;
-    dp = 3 - 2*radius;
-    while(x1<=y1)
     {
-        if(dp<=0)
-            dp += (4 * x1) + 6;
-        else
-        {
-            dp += 4*(x1-y1)+10;
-            y1--;
+        std::lock_guard<std::mutex> lock(this->frameMutex);
+
+        for(int page = 0; page < PAGES; page++) {
+            this->back->dirtyStart[page] = std::min(this->back->dirtyStart[page], this->pending->dirtyStart[page]);
+            this->back->dirtyEnd[page] = std::max(this->back->dirtyEnd[page], this->pending->dirtyEnd[page]);
         }
-        x1++;
-        drawPixel(x1+x, y1+y, color);
-        drawPixel(x1+x, y-y1, color);
-        drawPixel(x-x1, y1+y, color);
-        drawPixel(x-x1, y-y1, color);
-        drawPixel(x+y1, y+x1, color);
-        drawPixel(x+y1, y-x1, color);
-        drawPixel(x-y1, y+x1, color);
-        drawPixel(x-y1, y-x1, color);
-    }
-}
-
-void SSD1306::fillCircle(int x, int y, int radius, int color) {
-    int dp;
-    int x1 = 0;
-    int y1 = radius;
-    dp = 3 - 2 * radius;
-
-    while (x1 <= y1) {
-        // Fill spans directly
-        for (int i = x - x1; i <= x + x1; i++) {
-            drawPixel(i, y - y1, color); // Top span
-            drawPixel(i, y + y1, color); // Bottom span
+        if(this->pendingReady) {
+            this->stats.framesDropped++;
         }
-        for (int i = x - y1; i <= x + y1; i++) {
-            drawPixel(i, y - x1, color); // Left span
-            drawPixel(i, y + x1, color); // Right span
+        std::swap(this->back, this->pending);
+        this->pendingReady = true;
+        this->stats.framesPresented++;
+
+        if(keepFrame) {
+            this->back->buffer = this->pending->buffer;
+            this->back->clearDirty();
         }
+    }
+    this->frameReady.notify_one();
+}
+
+// Start sending presented frames from a background thread
+template<class Layout>
+void SSD1306Driver<Layout>::startFlushThread() {
+
+    std::lock_guard<std::mutex> lock(this->frameMutex);
+
+    if(this->flushRunning) {
+        return;
+    }
+    // The pending frame starts as the one sent last, updateRegion() draws over it
+    this->pending->buffer = this->back->buffer;
+    this->pending->clearDirty();
+    this->pendingReady = false;
+    this->flushRunning = true;
+    this->flushThread = std::thread(&SSD1306Driver::flushLoop, this);
+}
+
+// Stop the flush thread after it has sent the last presented frame
+template<class Layout>
+void SSD1306Driver<Layout>::stopFlushThread() {
 
-        if (dp <= 0) {
-            dp += (4 * x1) + 6;
-        } else {
-            dp += 4 * (x1 - y1) + 10;
-            y1--;
+    {
+        std::lock_guard<std::mutex> lock(this->frameMutex);
+        if(!this->flushRunning) {
+            return;
         }
-        x1++;
+        this->flushRunning = false;
     }
+    this->frameReady.notify_one();
+    this->flushThread.join();
 }
 
-void SSD1306::draw_64(uint64_t* bitmap) {
-    std::memcpy(this->frameBuffer, bitmap, 1024);
+template<class Layout>
+bool SSD1306Driver<Layout>::isFlushThreadRunning() const {
+    return this->flushThread.joinable();
 }
 
-void SSD1306::renderDisplay(int startPage, int endPage) {
+template<class Layout>
+SSD1306Stats SSD1306Driver<Layout>::getStats() {
+    std::lock(this->frameMutex, this->busMutex);
+    std::lock_guard<std::mutex> frame_lock(this->frameMutex, std::adopt_lock);
+    std::lock_guard<std::mutex> bus_lock(this->busMutex, std::adopt_lock);
+    return this->stats;
+}
 
-    uint8_t pageBuffer[129];   // Page buffer with control byte for data
-    pageBuffer[0] = 0x40;
+// Takes the latest presented frame and sends it while the caller draws the next one
+template<class Layout>
+void SSD1306Driver<Layout>::flushLoop() {
 
-    for(int page = 0; page < 8; page++) {
-        for(int col = 0; col < 128; col++) {
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(this->frameMutex);
+            this->frameReady.wait(lock, [this] { return this->pendingReady || !this->flushRunning; });
 
-            pageBuffer[col + 1] = ((this->frameBuffer[col]) >> (page*8)) & 0xFF;
-        }
-        
-        if(setCursor(0, page) < 3) {
-            std::cout << "Error setting cursor" << std::endl;
-        } 
-        else {
-            if(write(this->file, pageBuffer, sizeof(pageBuffer)) != sizeof(pageBuffer)) {
-                std::cout << "There was an error writing page" << std::endl;
-                break;
+            if(!this->pendingReady) {
+                return;
             }
+            // pending starts over as a copy, regions from updateRegion() are drawn over the latest frame
+            std::swap(this->front, this->pending);
+            this->pending->buffer = this->front->buffer;
+            this->pending->clearDirty();
+            this->pendingReady = false;
         }
+
+        {
+            std::lock_guard<std::mutex> lock(this->busMutex);
+            renderSlot(this->front, 0, PAGES - 1);
+        }
+
+        std::lock_guard<std::mutex> lock(this->frameMutex);
+        this->stats.framesFlushed++;
     }
 }
 
-void SSD1306::startHorizontalScroll(int startPage, int endPage, int direction, int speed) {
+template<class Layout>
+void SSD1306Driver<Layout>::startHorizontalScroll(int startPage, int endPage, int direction, int speed) {
 
-    if((startPage < 0 || startPage > 7) || (endPage < 0 || endPage > 7)) {
+    if((startPage < 0 || startPage > Panel::PAGES - 1) || (endPage < 0 || endPage > Panel::PAGES - 1)) {
         std::cout << "Horizontal scrolling page index error : [" << startPage << " : " << endPage << "]" << std::endl;
         return;
     }
@@ -385,19 +885,19 @@ void SSD1306::startHorizontalScroll(int startPage, int endPage, int direction, i
         0xFF
     };
 
-    int scrollStatus = sendCommand(commands, sizeof(commands));
-    if(scrollStatus != (sizeof(commands) + 1)) {
-        std::cerr << "Scrolling configuration failed: (" << scrollStatus << ") " << strerror(scrollStatus) << " while writing" << std::endl;
-        return;
-    }
+    // Configuration and activation go out in the same batch
     const uint8_t start_scroll = 0x2F;
-    scrollStatus = sendCommand(&start_scroll, 1);
-    if(scrollStatus != 2) {
-        std::cerr << "Starting scrolling failed: (" << scrollStatus << ") " << strerror(scrollStatus) << " while writing" << std::endl;
+    queueCommand(commands, sizeof(commands));
+    queueCommand(&start_scroll, 1);
+
+    int scrollStatus = flushCommands();
+    if(scrollStatus != (sizeof(commands) + 1 + 2)) {
+        std::cerr << "Scrolling configuration failed: (" << scrollStatus << ") " << strerror(scrollStatus) << " while writing" << std::endl;
     }
 }
 
-void SSD1306::startDiagonalRightScrl(int startPage, int endPage) {
+template<class Layout>
+void SSD1306Driver<Layout>::startDiagonalRightScrl(int startPage, int endPage) {
 
     uint8_t start = (uint8_t)startPage;
     uint8_t end = (uint8_t)endPage;
@@ -411,12 +911,14 @@ void SSD1306::startDiagonalRightScrl(int startPage, int endPage) {
         0x3F
     };
 
-    sendCommand(commands, sizeof(commands));
     const uint8_t start_scroll = 0x2F;
-    sendCommand(&start_scroll, 1);
+    queueCommand(commands, sizeof(commands));
+    queueCommand(&start_scroll, 1);
+    flushCommands();
 }
 
-void SSD1306::startDiagonalLeftScrl(int startPage, int endPage) {
+template<class Layout>
+void SSD1306Driver<Layout>::startDiagonalLeftScrl(int startPage, int endPage) {
 
     uint8_t start = (uint8_t)startPage;
     uint8_t end = (uint8_t)endPage;
@@ -447,281 +949,68 @@ void SSD1306::startDiagonalLeftScrl(int startPage, int endPage) {
     std::cout << "Started diag scroll " << (sendCommand(&start_scroll, 1) == 2) << std::endl;;
 }
 
-void SSD1306::stopScroll() {
+template<class Layout>
+void SSD1306Driver<Layout>::stopScroll() {
     const uint8_t stop_scroll = 0x2E;
     sendCommand(&stop_scroll, 1);
 }
 
-uint8_t* SSD1306::ASCIImap(char c) {
-
-    static unsigned char font_bitmap_6x8[] = {
-        0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-        0x38,0x74,0x5c,0x74,0x38,0x00,0x00,0x00,
-        0x38,0x74,0x7c,0x74,0x38,0x00,0x00,0x00,
-        0x18,0x3c,0x78,0x3c,0x18,0x00,0x00,0x00,
-        0x10,0x38,0x7c,0x38,0x10,0x00,0x00,0x00,
-        0x18,0x14,0x7c,0x14,0x18,0x00,0x00,0x00,
-        0x30,0x18,0x7c,0x18,0x30,0x00,0x00,0x00,
-        0x00,0x10,0x38,0x10,0x00,0x00,0x00,0x00,
-        0xfe,0xee,0xc6,0xee,0xfe,0x00,0x00,0x00,
-        0x00,0x10,0x28,0x10,0x00,0x00,0x00,0x00,
-        0xfe,0xee,0xc6,0xee,0xfe,0x00,0x00,0x00,
-        0x20,0x50,0x34,0x0c,0x1c,0x00,0x00,0x00,
-        0x00,0x28,0x74,0x28,0x00,0x00,0x00,0x00,
-        0x60,0x38,0x04,0x08,0x00,0x00,0x00,0x00,
-        0x60,0x38,0x04,0x34,0x1c,0x00,0x00,0x00,
-        0x00,0x10,0x28,0x10,0x00,0x00,0x00,0x00,
-        0x00,0x7c,0x38,0x10,0x00,0x00,0x00,0x00,
-        0x00,0x10,0x38,0x7c,0x00,0x00,0x00,0x00,
-        0x00,0x28,0x7c,0x28,0x00,0x00,0x00,0x00,
-        0x00,0x5c,0x00,0x5c,0x00,0x00,0x00,0x00,
-        0x18,0xfc,0x04,0xfc,0x04,0x00,0x00,0x00,
-        0x90,0xa8,0x48,0x54,0x24,0x00,0x00,0x00,
-        0x60,0x60,0x60,0x60,0x60,0x00,0x00,0x00,
-        0x00,0xa8,0xfc,0xa8,0x00,0x00,0x00,0x00,
-        0x00,0x08,0x7c,0x08,0x00,0x00,0x00,0x00,
-        0x00,0x20,0x7c,0x20,0x00,0x00,0x00,0x00,
-        0x10,0x10,0x10,0x38,0x10,0x00,0x00,0x00,
-        0x10,0x38,0x10,0x10,0x10,0x00,0x00,0x00,
-        0x30,0x20,0x20,0x20,0x20,0x00,0x00,0x00,
-        0x10,0x38,0x10,0x38,0x10,0x00,0x00,0x00,
-        0x40,0x60,0x70,0x60,0x40,0x00,0x00,0x00,
-        0x10,0x30,0x70,0x30,0x10,0x00,0x00,0x00,
-        0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x00,0x5c,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x0c,0x00,0x0c,0x00,0x00,0x00,0x00,
-        0x28,0x7c,0x28,0x7c,0x28,0x00,0x00,0x00,
-        0x00,0x50,0xec,0x28,0x00,0x00,0x00,0x00,
-        0x44,0x2a,0x34,0x58,0x24,0x00,0x00,0x00,
-        0x20,0x58,0x54,0x24,0x50,0x00,0x00,0x00,
-        0x00,0x00,0x06,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x38,0x44,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x44,0x38,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x54,0x38,0x54,0x00,0x00,0x00,0x00,
-        0x00,0x10,0x38,0x10,0x00,0x00,0x00,0x00,
-        0x00,0x80,0x40,0x00,0x00,0x00,0x00,0x00,
-        0x08,0x08,0x08,0x08,0x00,0x00,0x00,0x00,
-        0x00,0x00,0x40,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x60,0x18,0x04,0x00,0x00,0x00,0x00,
-        0x38,0x44,0x44,0x38,0x00,0x00,0x00,0x00,
-        0x00,0x08,0x7c,0x00,0x00,0x00,0x00,0x00,
-        0x48,0x64,0x54,0x48,0x00,0x00,0x00,0x00,
-        0x44,0x54,0x54,0x28,0x00,0x00,0x00,0x00,
-        0x20,0x30,0x28,0x7c,0x00,0x00,0x00,0x00,
-        0x5c,0x54,0x54,0x24,0x00,0x00,0x00,0x00,
-        0x38,0x54,0x54,0x20,0x00,0x00,0x00,0x00,
-        0x04,0x64,0x14,0x0c,0x00,0x00,0x00,0x00,
-        0x28,0x54,0x54,0x28,0x00,0x00,0x00,0x00,
-        0x08,0x54,0x54,0x38,0x00,0x00,0x00,0x00,
-        0x00,0x00,0x50,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x80,0x50,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x10,0x28,0x44,0x00,0x00,0x00,0x00,
-        0x00,0x28,0x28,0x28,0x00,0x00,0x00,0x00,
-        0x00,0x44,0x28,0x10,0x00,0x00,0x00,0x00,
-        0x00,0x54,0x14,0x08,0x00,0x00,0x00,0x00,
-        0x38,0x44,0x54,0x54,0x08,0x00,0x00,0x00,
-        0x78,0x14,0x14,0x78,0x00,0x00,0x00,0x00,
-        0x7c,0x54,0x54,0x28,0x00,0x00,0x00,0x00,
-        0x38,0x44,0x44,0x44,0x00,0x00,0x00,0x00,
-        0x7c,0x44,0x44,0x38,0x00,0x00,0x00,0x00,
-        0x7c,0x54,0x54,0x44,0x00,0x00,0x00,0x00,
-        0x7c,0x14,0x14,0x04,0x00,0x00,0x00,0x00,
-        0x38,0x44,0x44,0x68,0x00,0x00,0x00,0x00,
-        0x7c,0x10,0x10,0x7c,0x00,0x00,0x00,0x00,
-        0x00,0x44,0x7c,0x44,0x00,0x00,0x00,0x00,
-        0x30,0x40,0x40,0x3c,0x00,0x00,0x00,0x00,
-        0x7c,0x10,0x28,0x44,0x00,0x00,0x00,0x00,
-        0x7c,0x40,0x40,0x40,0x00,0x00,0x00,0x00,
-        0x7c,0x10,0x10,0x7c,0x00,0x00,0x00,0x00,
-        0x7c,0x08,0x10,0x7c,0x00,0x00,0x00,0x00,
-        0x38,0x44,0x44,0x38,0x00,0x00,0x00,0x00,
-        0x7c,0x14,0x14,0x08,0x00,0x00,0x00,0x00,
-        0x38,0x44,0x44,0xb8,0x00,0x00,0x00,0x00,
-        0x7c,0x14,0x14,0x68,0x00,0x00,0x00,0x00,
-        0x48,0x54,0x54,0x24,0x00,0x00,0x00,0x00,
-        0x04,0x04,0x7c,0x04,0x04,0x00,0x00,0x00,
-        0x3c,0x40,0x40,0x3c,0x00,0x00,0x00,0x00,
-        0x1c,0x60,0x60,0x1c,0x00,0x00,0x00,0x00,
-        0x1c,0x60,0x18,0x60,0x1c,0x00,0x00,0x00,
-        0x4c,0x30,0x10,0x6c,0x00,0x00,0x00,0x00,
-        0x00,0x1c,0x60,0x1c,0x00,0x00,0x00,0x00,
-        0x64,0x54,0x4c,0x44,0x00,0x00,0x00,0x00,
-        0x00,0x7c,0x44,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x0c,0x30,0x40,0x00,0x00,0x00,0x00,
-        0x00,0x44,0x7c,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x08,0x04,0x08,0x00,0x00,0x00,0x00,
-        0x80,0x80,0x80,0x80,0x80,0x00,0x00,0x00,
-        0x00,0x04,0x08,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x68,0x28,0x70,0x00,0x00,0x00,0x00,
-        0x7e,0x48,0x48,0x30,0x00,0x00,0x00,0x00,
-        0x00,0x30,0x48,0x48,0x00,0x00,0x00,0x00,
-        0x30,0x48,0x48,0x7c,0x00,0x00,0x00,0x00,
-        0x30,0x58,0x58,0x50,0x00,0x00,0x00,0x00,
-        0x10,0x78,0x14,0x04,0x00,0x00,0x00,0x00,
-        0x10,0xa8,0xa8,0x78,0x00,0x00,0x00,0x00,
-        0x7c,0x08,0x08,0x70,0x00,0x00,0x00,0x00,
-        0x00,0x48,0x7a,0x40,0x00,0x00,0x00,0x00,
-        0x00,0x80,0x80,0x7a,0x00,0x00,0x00,0x00,
-        0x7c,0x10,0x28,0x40,0x00,0x00,0x00,0x00,
-        0x00,0x42,0x7e,0x40,0x00,0x00,0x00,0x00,
-        0x78,0x10,0x10,0x78,0x00,0x00,0x00,0x00,
-        0x78,0x08,0x08,0x70,0x00,0x00,0x00,0x00,
-        0x30,0x48,0x48,0x30,0x00,0x00,0x00,0x00,
-        0xf8,0x48,0x48,0x30,0x00,0x00,0x00,0x00,
-        0x30,0x48,0x48,0xf8,0x00,0x00,0x00,0x00,
-        0x00,0x78,0x10,0x08,0x00,0x00,0x00,0x00,
-        0x50,0x58,0x68,0x28,0x00,0x00,0x00,0x00,
-        0x08,0x3c,0x48,0x48,0x00,0x00,0x00,0x00,
-        0x38,0x40,0x40,0x78,0x00,0x00,0x00,0x00,
-        0x18,0x60,0x60,0x18,0x00,0x00,0x00,0x00,
-        0x78,0x20,0x20,0x78,0x00,0x00,0x00,0x00,
-        0x48,0x30,0x30,0x48,0x00,0x00,0x00,0x00,
-        0x18,0xa0,0xa0,0x78,0x00,0x00,0x00,0x00,
-        0x48,0x68,0x58,0x48,0x00,0x00,0x00,0x00,
-        0x00,0x18,0x24,0x42,0x00,0x00,0x00,0x00,
-        0x00,0x00,0x7e,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x42,0x24,0x18,0x00,0x00,0x00,0x00,
-        0x10,0x08,0x10,0x08,0x00,0x00,0x00,0x00,
-        0x60,0x50,0x48,0x50,0x60,0x00,0x00,0x00,
-        0x38,0x44,0xc4,0x44,0x00,0x00,0x00,0x00,
-        0x38,0x42,0x40,0x7a,0x00,0x00,0x00,0x00,
-        0x30,0x58,0x5a,0x51,0x00,0x00,0x00,0x00,
-        0x28,0x4a,0x31,0x42,0x00,0x00,0x00,0x00,
-        0x48,0x2a,0x70,0x42,0x00,0x00,0x00,0x00,
-        0x48,0x29,0x72,0x40,0x00,0x00,0x00,0x00,
-        0x48,0x28,0x72,0x40,0x00,0x00,0x00,0x00,
-        0x00,0x30,0xc8,0x48,0x00,0x00,0x00,0x00,
-        0x30,0x5a,0x59,0x52,0x00,0x00,0x00,0x00,
-        0x30,0x5a,0x58,0x52,0x00,0x00,0x00,0x00,
-        0x30,0x59,0x5a,0x50,0x00,0x00,0x00,0x00,
-        0x00,0x4a,0x78,0x42,0x00,0x00,0x00,0x00,
-        0x00,0x4a,0x79,0x42,0x00,0x00,0x00,0x00,
-        0x00,0x49,0x7a,0x40,0x00,0x00,0x00,0x00,
-        0x79,0x14,0x15,0x78,0x00,0x00,0x00,0x00,
-        0x78,0x14,0x15,0x78,0x00,0x00,0x00,0x00,
-        0x7c,0x54,0x56,0x45,0x00,0x00,0x00,0x00,
-        0x68,0x38,0x70,0x58,0x58,0x00,0x00,0x00,
-        0x78,0x14,0x7c,0x54,0x00,0x00,0x00,0x00,
-        0x30,0x4a,0x49,0x32,0x00,0x00,0x00,0x00,
-        0x30,0x4a,0x48,0x32,0x00,0x00,0x00,0x00,
-        0x30,0x49,0x4a,0x30,0x00,0x00,0x00,0x00,
-        0x38,0x42,0x41,0x7a,0x00,0x00,0x00,0x00,
-        0x38,0x41,0x42,0x78,0x00,0x00,0x00,0x00,
-        0x18,0xa2,0xa0,0x7a,0x00,0x00,0x00,0x00,
-        0x30,0x4a,0x48,0x32,0x00,0x00,0x00,0x00,
-        0x3c,0x41,0x40,0x3d,0x00,0x00,0x00,0x00,
-        0x30,0x48,0xcc,0x48,0x00,0x00,0x00,0x00,
-        0x50,0x7c,0x52,0x46,0x00,0x00,0x00,0x00,
-        0x02,0x2e,0x70,0x2e,0x02,0x00,0x00,0x00,
-        0x7e,0x12,0x1c,0x38,0x50,0x00,0x00,0x00,
-        0x90,0x7c,0x12,0x12,0x00,0x00,0x00,0x00,
-        0x48,0x2a,0x71,0x40,0x00,0x00,0x00,0x00,
-        0x00,0x48,0x7a,0x41,0x00,0x00,0x00,0x00,
-        0x30,0x48,0x4a,0x31,0x00,0x00,0x00,0x00,
-        0x38,0x40,0x42,0x79,0x00,0x00,0x00,0x00,
-        0x7a,0x09,0x0a,0x71,0x00,0x00,0x00,0x00,
-        0x7e,0x19,0x22,0x7d,0x00,0x00,0x00,0x00,
-        0x00,0x24,0x2a,0x2c,0x00,0x00,0x00,0x00,
-        0x00,0x24,0x2a,0x24,0x00,0x00,0x00,0x00,
-        0x20,0x50,0x4a,0x20,0x00,0x00,0x00,0x00,
-        0x60,0x20,0x20,0x20,0x20,0x00,0x00,0x00,
-        0x20,0x20,0x20,0x20,0x60,0x00,0x00,0x00,
-        0x2e,0x10,0x48,0x54,0x70,0x00,0x00,0x00,
-        0x2e,0x10,0x48,0x64,0xf2,0x00,0x00,0x00,
-        0x00,0x20,0x7a,0x20,0x00,0x00,0x00,0x00,
-        0x20,0x50,0x20,0x50,0x00,0x00,0x00,0x00,
-        0x50,0x20,0x50,0x20,0x00,0x00,0x00,0x00,
-        0x55,0xaa,0x55,0xaa,0x55,0x00,0x00,0x00,
-        0x55,0xbb,0x55,0xee,0x55,0x00,0x00,0x00,
-        0x55,0xff,0xaa,0xff,0x55,0x00,0x00,0x00,
-        0x00,0x00,0xff,0x00,0x00,0x00,0x00,0x00,
-        0x08,0x08,0xff,0x00,0x00,0x00,0x00,0x00,
-        0x14,0x14,0xff,0x00,0x00,0x00,0x00,0x00,
-        0x08,0xff,0x00,0xff,0x00,0x00,0x00,0x00,
-        0x08,0xf8,0x08,0xf8,0x00,0x00,0x00,0x00,
-        0x14,0x14,0xfc,0x00,0x00,0x00,0x00,0x00,
-        0x14,0xf7,0x00,0xff,0x00,0x00,0x00,0x00,
-        0x00,0xff,0x00,0xff,0x00,0x00,0x00,0x00,
-        0x14,0xf4,0x04,0xfc,0x00,0x00,0x00,0x00,
-        0x14,0x17,0x10,0x1f,0x00,0x00,0x00,0x00,
-        0x08,0x0f,0x08,0x0f,0x00,0x00,0x00,0x00,
-        0x14,0x14,0x1f,0x00,0x00,0x00,0x00,0x00,
-        0x08,0x08,0xf8,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x00,0x0f,0x08,0x08,0x00,0x00,0x00,
-        0x08,0x08,0x0f,0x08,0x08,0x00,0x00,0x00,
-        0x08,0x08,0xf8,0x08,0x08,0x00,0x00,0x00,
-        0x00,0x00,0xff,0x08,0x08,0x00,0x00,0x00,
-        0x08,0x08,0x08,0x08,0x08,0x00,0x00,0x00,
-        0x08,0x08,0xff,0x08,0x08,0x00,0x00,0x00,
-        0x00,0x00,0xff,0x14,0x14,0x00,0x00,0x00,
-        0x00,0xff,0x00,0xff,0x08,0x00,0x00,0x00,
-        0x00,0x1f,0x10,0x17,0x14,0x00,0x00,0x00,
-        0x00,0xfc,0x04,0xf4,0x14,0x00,0x00,0x00,
-        0x14,0x17,0x10,0x17,0x14,0x00,0x00,0x00,
-        0x14,0xf4,0x04,0xf4,0x14,0x00,0x00,0x00,
-        0x00,0xff,0x00,0xf7,0x14,0x00,0x00,0x00,
-        0x14,0x14,0x14,0x14,0x14,0x00,0x00,0x00,
-        0x14,0xf7,0x00,0xf7,0x14,0x00,0x00,0x00,
-        0x14,0x14,0x17,0x14,0x14,0x00,0x00,0x00,
-        0x08,0x0f,0x08,0x0f,0x08,0x00,0x00,0x00,
-        0x14,0x14,0xf4,0x14,0x14,0x00,0x00,0x00,
-        0x08,0xf8,0x08,0xf8,0x08,0x00,0x00,0x00,
-        0x00,0x0f,0x08,0x0f,0x08,0x00,0x00,0x00,
-        0x00,0x00,0x1f,0x14,0x14,0x00,0x00,0x00,
-        0x00,0x00,0xfc,0x14,0x14,0x00,0x00,0x00,
-        0x00,0xf8,0x08,0xf8,0x08,0x00,0x00,0x00,
-        0x08,0xff,0x08,0xff,0x08,0x00,0x00,0x00,
-        0x14,0x14,0xff,0x14,0x14,0x00,0x00,0x00,
-        0x08,0x08,0x0f,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x00,0xf8,0x08,0x08,0x00,0x00,0x00,
-        0xff,0xff,0xff,0xff,0xff,0x00,0x00,0x00,
-        0xf0,0xf0,0xf0,0xf0,0xf0,0x00,0x00,0x00,
-        0xff,0xff,0xff,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x00,0x00,0xff,0xff,0x00,0x00,0x00,
-        0x0f,0x0f,0x0f,0x0f,0x0f,0x00,0x00,0x00,
-        0x30,0x48,0x48,0x30,0x48,0x00,0x00,0x00,
-        0xfc,0x4a,0x4a,0x3c,0x00,0x00,0x00,0x00,
-        0x00,0x7e,0x02,0x02,0x00,0x00,0x00,0x00,
-        0x00,0x7c,0x04,0x7c,0x00,0x00,0x00,0x00,
-        0x62,0x56,0x4a,0x42,0x66,0x00,0x00,0x00,
-        0x38,0x44,0x44,0x3c,0x04,0x00,0x00,0x00,
-        0xf8,0x40,0x40,0x38,0x40,0x00,0x00,0x00,
-        0x02,0x04,0x78,0x06,0x02,0x00,0x00,0x00,
-        0x10,0x28,0xee,0x28,0x10,0x00,0x00,0x00,
-        0x38,0x54,0x54,0x54,0x38,0x00,0x00,0x00,
-        0x58,0x64,0x04,0x64,0x58,0x00,0x00,0x00,
-        0x32,0x4d,0x49,0x30,0x00,0x00,0x00,0x00,
-        0x30,0x48,0x78,0x48,0x30,0x00,0x00,0x00,
-        0x50,0x28,0x58,0x48,0x34,0x00,0x00,0x00,
-        0x00,0x3c,0x4a,0x4a,0x00,0x00,0x00,0x00,
-        0x7c,0x02,0x02,0x7c,0x00,0x00,0x00,0x00,
-        0x54,0x54,0x54,0x54,0x00,0x00,0x00,0x00,
-        0x48,0x48,0x5c,0x48,0x48,0x00,0x00,0x00,
-        0x40,0x62,0x54,0x48,0x00,0x00,0x00,0x00,
-        0x00,0x48,0x54,0x62,0x00,0x00,0x00,0x00,
-        0x00,0x00,0xf8,0x04,0x0c,0x00,0x00,0x00,
-        0x30,0x20,0x1f,0x00,0x00,0x00,0x00,0x00,
-        0x10,0x54,0x54,0x10,0x00,0x00,0x00,0x00,
-        0x48,0x24,0x48,0x24,0x00,0x00,0x00,0x00,
-        0x00,0x08,0x14,0x08,0x00,0x00,0x00,0x00,
-        0x00,0x18,0x18,0x00,0x00,0x00,0x00,0x00,
-        0x00,0x00,0x08,0x00,0x00,0x00,0x00,0x00,
-        0x20,0x40,0x30,0x0c,0x04,0x00,0x00,0x00,
-        0x00,0x0e,0x02,0x0c,0x00,0x00,0x00,0x00,
-        0x00,0x12,0x1a,0x14,0x00,0x00,0x00,0x00,
-        0x00,0x38,0x38,0x38,0x00,0x00,0x00,0x00,
-        0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
-};
-
-    // Endpoints to restrict charcater set
-    uint8_t char_set_start = 0x00;
-    uint8_t char_set_end = 0xFF;
-
-    if(char_set_start < 0 || char_set_end > 255) {
-        return nullptr;
+// Appends a line of text at the bottom and moves everything else up by one
+// page. The GRAM is used as a ring: the display start line is advanced by a
+// page and only the new line is written, to the GRAM page that scrolls into
+// view, in the same batch right before the start line command. The frame
+// buffer and the shadow copy are shifted so later renders stay consistent.
+// With the flush thread running the shifted frame is presented instead.
+template<class Layout>
+void SSD1306Driver<Layout>::consoleLine(const std::string& text) {
+
+    // Move the frame and its dirty spans up by one text row
+    this->back->scrollUp();
+    this->back->drawText(text, 0, HEIGHT - 8);
+
+    // The rows of a turned frame are panel columns, the start line can't move them
+    if(isFlushThreadRunning() || Map::TRANSPOSED) {
+        renderDisplay(0, PAGES - 1);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->busMutex);
+
+    // The GRAM keeps its content, only the page mapping moves. When the panel
+    // shows every GRAM page the page leaving at the top is the one the new
+    // line goes to, so its known content carries over to the bottom.
+    const bool ring = (PAGES == GRAM_PAGES);
+
+    for(int col = 0; col < WIDTH; col++) {
+        const uint64_t rows = this->shadow.column(col);
+        this->shadow.setColumn(col, ring ? (rows >> 8) | (rows << (HEIGHT - 8)) : rows >> 8);
+    }
+    if(ring) {
+        this->shadowPages = static_cast<uint8_t>((this->shadowPages >> 1) | ((this->shadowPages & 1) << (PAGES - 1)));
     }
     else {
-        int char_index = (c - char_set_start) * 8;
-        return &font_bitmap_6x8[char_index];
+        this->shadowPages >>= 1;
     }
+    this->scrollPage = (this->scrollPage + 1) % GRAM_PAGES;
+
+    if(!busReady()) {
+        return;
+    }
+    queueSlot(this->back, 0, PAGES - 1);
+
+    const uint8_t start_line = static_cast<uint8_t>(SET_DISP_START_LN | (this->scrollPage * 8));
+    this->transport->queueCommand(&start_line, 1);
+    flushWindows();
 }
+
+// Panels and layouts the driver is built for
+template class SSD1306Driver<ColumnMajor<128, 64>>;
+template class SSD1306Driver<ColumnMajor<128, 32>>;
+template class SSD1306Driver<ColumnMajor<96, 16>>;
+template class SSD1306Driver<ColumnMajor<64, 48>>;
+template class SSD1306Driver<PageMajor<128, 64>>;
+template class SSD1306Driver<PageMajor<128, 32>>;
+template class SSD1306Driver<PageMajor<96, 16>>;
+template class SSD1306Driver<PageMajor<64, 48>>;
+template class SSD1306Driver<QuarterTurn<ColumnMajor<48, 64>>>;
+template class SSD1306Driver<QuarterTurn<PageMajor<48, 64>>>;
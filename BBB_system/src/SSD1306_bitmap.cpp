@@ -0,0 +1,85 @@
+/*
+    SSD1306_bitmap.cpp
+
+*/
+#include "SSD1306_bitmap.h"
+
+// Empty bitmap, the height is limited to the 64 rows of a column word
+Bitmap::Bitmap(int width, int height) : width(width), height(height) {
+
+    if(this->width < 0) {
+        this->width = 0;
+    }
+    if(this->height < 0 || this->height > 64) {
+        std::cerr << "Bitmap height " << height << " out of range, has to be 0 - 64" << std::endl;
+        this->height = (this->height < 0) ? 0 : 64;
+    }
+    this->columns.assign(this->width, 0);
+}
+
+// 8 rows tall bitmap from one byte per column, the format draw_8 takes
+Bitmap::Bitmap(const uint8_t* columns, int width) : Bitmap(width, 8) {
+
+    for(int x = 0; x < this->width; x++) {
+        this->columns[x] = columns[x];
+    }
+}
+
+// Bitmap from column words, bits past the height are ignored
+Bitmap::Bitmap(const uint64_t* columns, int width, int height) : Bitmap(width, height) {
+
+    for(int x = 0; x < this->width; x++) {
+        setColumn(x, columns[x]);
+    }
+}
+
+int Bitmap::getWidth() const {
+    return this->width;
+}
+
+int Bitmap::getHeight() const {
+    return this->height;
+}
+
+// One bit for every row of the bitmap
+uint64_t Bitmap::rowsMask() const {
+    return (this->height == 0) ? 0 : ~0ULL >> (64 - this->height);
+}
+
+uint64_t Bitmap::column(int x) const {
+    return this->columns[x];
+}
+
+// All columns, one word each
+const uint64_t* Bitmap::data() const {
+    return this->columns.data();
+}
+
+void Bitmap::setColumn(int x, uint64_t rows) {
+    this->columns[x] = rows & rowsMask();
+}
+
+void Bitmap::setPixel(int x, int y, bool is_on) {
+
+    if(x < 0 || x >= this->width || y < 0 || y >= this->height) {
+        return;
+    }
+    if(is_on) {
+        this->columns[x] |= 1ULL << y;
+    }
+    else {
+        this->columns[x] &= ~(1ULL << y);
+    }
+}
+
+bool Bitmap::getPixel(int x, int y) const {
+
+    if(x < 0 || x >= this->width || y < 0 || y >= this->height) {
+        return false;
+    }
+    return (this->columns[x] >> y) & 1;
+}
+
+void Bitmap::clear() {
+    this->columns.assign(this->width, 0);
+}
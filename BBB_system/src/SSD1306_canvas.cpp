@@ -0,0 +1,1057 @@
+/*
+    SSD1306_canvas.cpp
+
+*/
+#include "SSD1306_canvas.h"
+
+template<class Layout>
+Canvas<Layout>::Canvas() : buffer() {
+
+    this->buffer.clear();
+    setView(View{0, 0, 0, 0, WIDTH - 1, HEIGHT - 1});
+    clearDirty();
+}
+
+// Clears every pixel, the whole canvas becomes dirty
+template<class Layout>
+void Canvas<Layout>::clear() {
+
+    this->buffer.clear();
+    markDirty(0, WIDTH - 1, ~0ULL);
+}
+
+// The pixels of the canvas
+template<class Layout>
+const Layout& Canvas<Layout>::getBuffer() const {
+    return this->buffer;
+}
+
+// Mark every page clean
+template<class Layout>
+void Canvas<Layout>::clearDirty() {
+
+    for(int page = 0; page < PAGES; page++) {
+        this->dirtyStart[page] = WIDTH;
+        this->dirtyEnd[page] = -1;
+    }
+}
+
+// Extend the dirty column span of every page touched by the rows mask
+template<class Layout>
+void Canvas<Layout>::markDirty(int x0, int x1, uint64_t rows) {
+
+    if(x0 < 0) x0 = 0;
+    if(x1 > WIDTH - 1) x1 = WIDTH - 1;
+    if(x0 > x1) return;
+
+    for(int page = 0; page < PAGES; page++) {
+        if((rows >> (page*8)) & 0xFF) {
+            this->dirtyStart[page] = std::min(x0, this->dirtyStart[page]);
+            this->dirtyEnd[page] = std::max(x1, this->dirtyEnd[page]);
+        }
+    }
+}
+
+// Moves the content and its dirty spans up by one page, the bottom page is cleared
+template<class Layout>
+void Canvas<Layout>::scrollUp() {
+
+    for(int col = 0; col < WIDTH; col++) {
+        this->buffer.setColumn(col, this->buffer.column(col) >> 8);
+    }
+    for(int page = 0; page < PAGES - 1; page++) {
+        this->dirtyStart[page] = this->dirtyStart[page + 1];
+        this->dirtyEnd[page] = this->dirtyEnd[page + 1];
+    }
+    this->dirtyStart[PAGES - 1] = WIDTH;
+    this->dirtyEnd[PAGES - 1] = -1;
+    markDirty(0, WIDTH - 1, 0xFFULL << (HEIGHT - 8));
+}
+
+// Narrows the clip rectangle to x0..x1, y0..y1 of the current viewport
+template<class Layout>
+void Canvas<Layout>::pushClip(int x0, int y0, int x1, int y1) {
+
+    if(x0 > x1) std::swap(x0, x1);
+    if(y0 > y1) std::swap(y0, y1);
+
+    pushView(this->view.x, this->view.y,
+        this->view.x + x0, this->view.y + y0, this->view.x + x1, this->view.y + y1);
+}
+
+// Moves the origin to (x, y) of the current viewport and clips the drawing
+// to width x height pixels from there
+template<class Layout>
+void Canvas<Layout>::pushViewport(int x, int y, int width, int height) {
+
+    const int left = this->view.x + x;
+    const int top = this->view.y + y;
+
+    pushView(left, top, left, top, left + width - 1, top + height - 1);
+}
+
+// Restores the viewport and clip rectangle from before the last push
+template<class Layout>
+void Canvas<Layout>::popClip() {
+
+    if(this->views.empty()) {
+        std::cerr << "Canvas: popClip without a push" << std::endl;
+        return;
+    }
+    setView(this->views.back());
+    this->views.pop_back();
+}
+
+// Saves the current view and switches to origin (x, y), the clip rectangle
+// x0..x1, y0..y1 is in canvas coordinates and can only shrink the current one
+template<class Layout>
+void Canvas<Layout>::pushView(int x, int y, int x0, int y0, int x1, int y1) {
+
+    this->views.push_back(this->view);
+
+    setView(View{x, y,
+        std::max(x0, this->view.x0), std::max(y0, this->view.y0),
+        std::min(x1, this->view.x1), std::min(y1, this->view.y1)});
+}
+
+template<class Layout>
+void Canvas<Layout>::setView(const View& view) {
+
+    this->view = view;
+    this->clipRows = (view.y0 <= view.y1) ? (~0ULL >> (63 - (view.y1 - view.y0))) << view.y0 : 0;
+}
+
+// Text is UTF-8 and drawn with 6 pixels per character. Characters left of
+// the clip rectangle are only decoded, then every glyph column goes straight
+// into the frame with the row shift worked out up front, up to the right
+// edge of the clip. ROP_COPY replaces whole 6x8 character cells, so text can
+// be drawn over what was there before.
+template<class Layout>
+void Canvas<Layout>::drawText(const std::string& text, int x, int y, RasterOp op) {
+
+    x += this->view.x;
+    y += this->view.y;
+
+    if(y <= -8 || y >= HEIGHT) {
+        return;
+    }
+
+    // Glyph bytes are shifted up or down, one of the two shifts is zero
+    const int up = std::max(y, 0);
+    const int down = std::max(-y, 0);
+    const uint64_t mask = ((0xFFULL << up) >> down) & this->clipRows;
+
+    // First character reaching into the clip rectangle
+    size_t i = 0;
+    int pen = x;
+    while(i < text.size() && pen + Font6x8::ADVANCE <= this->view.x0) {
+        nextCodePoint(text, i);
+        pen += Font6x8::ADVANCE;
+    }
+
+    const int x0 = std::max(pen, this->view.x0);
+    int col = x0;
+
+    while(i < text.size() && col <= this->view.x1) {
+
+        const uint8_t* glyph = Font6x8::unicode(nextCodePoint(text, i));
+        const int end = std::min(pen + Font6x8::ADVANCE - 1, this->view.x1);
+
+        for(; col <= end; col++) {
+
+            const uint64_t bits = ((static_cast<uint64_t>(glyph[col - pen]) << up) >> down) & mask;
+
+            switch(op) {
+                case ROP_COPY:
+                    this->buffer.setColumn(col, (this->buffer.column(col) & ~mask) | bits);
+                    break;
+                case ROP_OR:
+                    this->buffer.orColumn(col, bits);
+                    break;
+                case ROP_AND_NOT:
+                    this->buffer.andNotColumn(col, bits);
+                    break;
+                case ROP_XOR:
+                    this->buffer.xorColumn(col, bits);
+                    break;
+            }
+        }
+        pen += Font6x8::ADVANCE;
+    }
+
+    if(col > x0) {
+        markDirty(x0, col - 1, mask);
+    }
+}
+
+// Text in a proportional font with (x, y) the top left corner of the line.
+// Glyph columns come from the font atlas and go into the frame like those of
+// the built-in font, the pen moves by each glyph's advance and the kerning
+// of each pair. ROP_COPY clears the line behind the whole text first.
+template<class Layout>
+void Canvas<Layout>::drawText(const Font& font, const std::string& text, int x, int y, RasterOp op) {
+
+    const int height = font.getHeight();
+
+    if(text.empty()) {
+        return;
+    }
+    if(op == ROP_COPY) {
+        const int width = font.measure(text);
+        if(width > 0) {
+            fillColumns(x, x + width - 1, spanMask(y, y + height - 1), BLACK);
+        }
+        op = ROP_OR;
+    }
+
+    x += this->view.x;
+    y += this->view.y;
+
+    if(y <= -height || y >= HEIGHT || this->view.x0 > this->view.x1) {
+        return;
+    }
+
+    const int up = std::max(y, 0);
+    const int down = std::max(-y, 0);
+    const uint64_t rows = (height >= 64) ? ~0ULL : ~0ULL >> (64 - height);
+    const uint64_t mask = ((rows << up) >> down) & this->clipRows;
+
+    int pen = x;
+    int first = WIDTH, last = -1;
+    uint32_t previous = 0;
+
+    for(size_t i = 0; i < text.size(); ) {
+
+        const size_t start = i;
+        const uint32_t code = nextCodePoint(text, i);
+        if(start > 0) {
+            pen += font.kerning(previous, code);
+        }
+        previous = code;
+
+        const FontGlyph& glyph = font.glyph(code);
+        const uint64_t* columns = font.columns(glyph);
+        const int left = pen + glyph.left;
+        const int x0 = std::max(left, this->view.x0);
+        const int x1 = std::min(left + glyph.width - 1, this->view.x1);
+        pen += glyph.advance;
+
+        for(int col = x0; col <= x1; col++) {
+
+            const uint64_t bits = ((columns[col - left] << up) >> down) & mask;
+
+            switch(op) {
+                case ROP_AND_NOT:
+                    this->buffer.andNotColumn(col, bits);
+                    break;
+                case ROP_XOR:
+                    this->buffer.xorColumn(col, bits);
+                    break;
+                default:
+                    this->buffer.orColumn(col, bits);
+                    break;
+            }
+        }
+        if(x0 <= x1) {
+            first = std::min(first, x0);
+            last = std::max(last, x1);
+        }
+    }
+    markDirty(first, last, mask);
+}
+
+// Text in a proportional font through a cache of rendered runs. A cached
+// run is drawn like a bitmap and looks the same as the text drawn with the
+// font directly, except that glyphs kerned into each other are merged first
+// so ROP_XOR toggles their shared pixels once.
+template<class Layout>
+void Canvas<Layout>::drawText(TextCache& cache, const Font& font, const std::string& text, int x, int y, RasterOp op) {
+
+    if(text.empty()) {
+        return;
+    }
+
+    drawRun(cache.run(font, text), x, y, op);
+}
+
+// A run from a TextCache with its pen position at (x, y), for callers that
+// already looked it up to measure the text
+template<class Layout>
+void Canvas<Layout>::drawRun(const TextRun& run, int x, int y, RasterOp op) {
+
+    if(op == ROP_COPY) {
+        if(run.advance > 0) {
+            fillColumns(x, x + run.advance - 1, spanMask(y, y + run.height - 1), BLACK);
+        }
+        op = ROP_OR;
+    }
+    blitColumns(run.columns.data(), static_cast<int>(run.columns.size()), run.height, x + run.left, y, op);
+}
+
+// ORs width columns of 8 rows at (x, y)
+template<class Layout>
+void Canvas<Layout>::draw_8(const uint8_t* bitmap, size_t width, int x, int y) {
+
+    x += this->view.x;
+    y += this->view.y;
+
+    const int x0 = std::max(x, this->view.x0);
+    const int x1 = std::min(x + static_cast<int>(width) - 1, this->view.x1);
+
+    if(x0 > x1 || y <= -8 || y >= HEIGHT) {
+        return;
+    }
+
+    const uint64_t mask = ((y >= 0) ? 0xFFULL << y : 0xFFULL >> -y) & this->clipRows;
+
+    for(int col = x0; col <= x1; col++) {
+        const uint64_t bits = bitmap[col - x];
+        this->buffer.orColumn(col, ((y >= 0) ? bits << y : bits >> -y) & mask);
+    }
+    markDirty(x0, x1, mask);
+}
+
+template<class Layout>
+void Canvas<Layout>::drawPixel(int x, int y, int color) {
+
+    x += this->view.x;
+    y += this->view.y;
+
+    if(x < this->view.x0 || x > this->view.x1 || y < this->view.y0 || y > this->view.y1) {
+        return;
+    }
+    color ? this->buffer.setPixel(x, y) : this->buffer.clearPixel(x, y);
+
+    int page = y >> 3;
+    if(x < this->dirtyStart[page]) this->dirtyStart[page] = x;
+    if(x > this->dirtyEnd[page]) this->dirtyEnd[page] = x;
+}
+
+// Lines are filled as the rectangle around them, the long edges offset half
+// the width to each side. A line of width 1 traces a single Bresenham edge.
+template<class Layout>
+void Canvas<Layout>::drawLine(int x0, int y0, int x1, int y1, int width, int color) {
+
+    const float length = std::sqrt(static_cast<float>((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0)));
+
+    if(width <= 1 || length == 0) {
+        const Point ends[] = {{x0, y0}, {x1, y1}};
+        fillConvex(ends, 2, color);
+        return;
+    }
+
+    // Offset of the long edges from the center line, the rounding is
+    // biased down so even widths are not one pixel too wide
+    const float half = (width - 1) / 2.0f;
+    const float nx = -(y1 - y0) * half / length;
+    const float ny = (x1 - x0) * half / length;
+    const int ax = static_cast<int>(std::floor(nx + 0.5f));
+    const int ay = static_cast<int>(std::floor(ny + 0.5f));
+    const int bx = static_cast<int>(std::floor(-nx + 0.5f));
+    const int by = static_cast<int>(std::floor(-ny + 0.5f));
+
+    const Point corners[] = {{x0 + ax, y0 + ay}, {x1 + ax, y1 + ay}, {x1 + bx, y1 + by}, {x0 + bx, y0 + by}};
+    fillConvex(corners, 4, color);
+}
+
+// Connected lines with round joins at the inner points
+template<class Layout>
+void Canvas<Layout>::drawPolyline(const std::vector<Point>& points, int width, int color) {
+
+    for(size_t i = 1; i < points.size(); i++) {
+        drawLine(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y, width, color);
+    }
+    drawJoins(points, false, width, color);
+}
+
+// Closed outline, the last point connects back to the first
+template<class Layout>
+void Canvas<Layout>::drawPolygon(const std::vector<Point>& points, int width, int color) {
+
+    for(size_t i = 0; i < points.size(); i++) {
+        const Point& next = points[(i + 1) % points.size()];
+        drawLine(points[i].x, points[i].y, next.x, next.y, width, color);
+    }
+    drawJoins(points, true, width, color);
+}
+
+// Fills a convex polygon one column span at a time, the filled area ends on
+// the same pixels drawPolygon draws with width 1. A concave polygon is filled
+// from the top to the bottom of each column.
+template<class Layout>
+void Canvas<Layout>::fillPolygon(const std::vector<Point>& points, int color) {
+    fillConvex(points.data(), points.size(), color);
+}
+
+// Traces the edges of count points into column extents and fills them, two
+// points are a single edge
+template<class Layout>
+void Canvas<Layout>::fillConvex(const Point* points, int count, int color) {
+
+    if(count <= 0) {
+        return;
+    }
+
+    // Only the columns between the leftmost and rightmost point are traced
+    int first = points[0].x;
+    int last = points[0].x;
+    for(int i = 1; i < count; i++) {
+        first = std::min(first, points[i].x);
+        last = std::max(last, points[i].x);
+    }
+    first = std::max(first + this->view.x, this->view.x0);
+    last = std::min(last + this->view.x, this->view.x1);
+
+    if(first > last) {
+        return;
+    }
+
+    int top[WIDTH];
+    int bottom[WIDTH];
+    std::fill(top + first, top + last + 1, HEIGHT);
+    std::fill(bottom + first, bottom + last + 1, -1);
+
+    const int edges = (count > 2) ? count : 1;
+    for(int i = 0; i < edges; i++) {
+        const Point& next = points[(i + 1) % count];
+        traceEdge(points[i].x, points[i].y, next.x, next.y, first, last, top, bottom);
+    }
+    fillTraced(top, bottom, first, last, color);
+}
+
+// Extends the per column extents with the pixels Bresenham's algorithm
+// visits from (x0, y0) to (x1, y1). The extents are kept in canvas
+// coordinates for the canvas columns first..last.
+template<class Layout>
+void Canvas<Layout>::traceEdge(int x0, int y0, int x1, int y1, int first, int last, int* top, int* bottom) const {
+
+    x0 += this->view.x;
+    x1 += this->view.x;
+    y0 += this->view.y;
+    y1 += this->view.y;
+
+    const int dx = std::abs(x1 - x0);
+    const int dy = -std::abs(y1 - y0);
+    const int xStep = (x0 < x1) ? 1 : -1;
+    const int yStep = (y0 < y1) ? 1 : -1;
+    int error = dx + dy;
+
+    while(true) {
+        if(x0 >= first && x0 <= last) {
+            top[x0] = std::min(top[x0], y0);
+            bottom[x0] = std::max(bottom[x0], y0);
+        }
+        if(x0 == x1 && y0 == y1) {
+            break;
+        }
+        const int error2 = 2 * error;
+        if(error2 >= dy) {
+            error += dy;
+            x0 += xStep;
+        }
+        if(error2 <= dx) {
+            error += dx;
+            y0 += yStep;
+        }
+    }
+}
+
+// Fills the traced extents of the columns first..last
+template<class Layout>
+void Canvas<Layout>::fillTraced(const int* top, const int* bottom, int first, int last, int color) {
+
+    uint64_t masks[WIDTH];
+
+    for(int col = first; col <= last; col++) {
+        masks[col] = panelRows(top[col], bottom[col]);
+    }
+    applyColumns(masks, first, last, color);
+}
+
+// Sets or clears the rows masks of the columns first..last clipped to the
+// clip rectangle, one masked operation per column and one dirty update for
+// the whole shape
+template<class Layout>
+void Canvas<Layout>::applyColumns(const uint64_t* masks, int first, int last, int color) {
+
+    int dirtyStart = WIDTH;
+    int dirtyEnd = -1;
+    uint64_t dirtyRows = 0;
+
+    for(int col = first; col <= last; col++) {
+
+        const uint64_t rows = masks[col] & this->clipRows;
+
+        if(!rows) {
+            continue;
+        }
+        color ? this->buffer.orColumn(col, rows) : this->buffer.andNotColumn(col, rows);
+
+        dirtyStart = std::min(dirtyStart, col);
+        dirtyEnd = col;
+        dirtyRows |= rows;
+    }
+    markDirty(dirtyStart, dirtyEnd, dirtyRows);
+}
+
+// Rows mask of the canvas rows y0..y1 clipped to the panel, 0 when empty
+template<class Layout>
+uint64_t Canvas<Layout>::panelRows(int y0, int y1) {
+
+    y0 = std::max(y0, 0);
+    y1 = std::min(y1, HEIGHT - 1);
+
+    return (y0 > y1) ? 0 : (~0ULL >> (63 - (y1 - y0))) << y0;
+}
+
+// Extends the column extents first..last with the midpoint disc of the
+// radius around (center_x, center_y), all in canvas coordinates. The
+// decision variable stays integer, every step covers the columns of both
+// octant pairs.
+template<class Layout>
+void Canvas<Layout>::traceDisc(int center_x, int center_y, int radius, int first, int last, int* top, int* bottom) {
+
+    int x1 = 0;
+    int y1 = radius;
+    int dp = 3 - 2 * radius;
+
+    auto extend = [&](int col, int half) {
+        if(col >= first && col <= last) {
+            top[col] = std::min(top[col], center_y - half);
+            bottom[col] = std::max(bottom[col], center_y + half);
+        }
+    };
+
+    while(x1 <= y1) {
+        extend(center_x - x1, y1);
+        extend(center_x + x1, y1);
+        extend(center_x - y1, x1);
+        extend(center_x + y1, x1);
+
+        if(dp <= 0) {
+            dp += (4 * x1) + 6;
+        } else {
+            dp += 4 * (x1 - y1) + 10;
+            y1--;
+        }
+        x1++;
+    }
+}
+
+// Sets the bits of the midpoint circle points in the column masks
+// first..last, canvas coordinates. quadrants selects the quarters that are
+// plotted: bit 0 top right, 1 top left, 2 bottom left, 3 bottom right.
+template<class Layout>
+void Canvas<Layout>::traceCircle(int center_x, int center_y, int radius, int quadrants, int first, int last, uint64_t* masks) {
+
+    int x1 = 0;
+    int y1 = radius;
+    int dp = 3 - 2 * radius;
+
+    auto plot = [&](int col, int row) {
+        if(col >= first && col <= last && row >= 0 && row < HEIGHT) {
+            masks[col] |= 1ULL << row;
+        }
+    };
+
+    while(x1 <= y1) {
+        if(quadrants & 1) { plot(center_x + x1, center_y - y1); plot(center_x + y1, center_y - x1); }
+        if(quadrants & 2) { plot(center_x - x1, center_y - y1); plot(center_x - y1, center_y - x1); }
+        if(quadrants & 4) { plot(center_x - x1, center_y + y1); plot(center_x - y1, center_y + x1); }
+        if(quadrants & 8) { plot(center_x + x1, center_y + y1); plot(center_x + y1, center_y + x1); }
+
+        if(dp <= 0) {
+            dp += (4 * x1) + 6;
+        } else {
+            dp += 4 * (x1 - y1) + 10;
+            y1--;
+        }
+        x1++;
+    }
+}
+
+// Round joins where thick lines meet, a gap would open on the outside of each bend otherwise
+template<class Layout>
+void Canvas<Layout>::drawJoins(const std::vector<Point>& points, bool closed, int width, int color) {
+
+    if(width <= 2 || points.empty()) {
+        return;
+    }
+    const size_t first = closed ? 0 : 1;
+    const size_t last = closed ? points.size() : points.size() - 1;
+
+    for(size_t i = first; i < last; i++) {
+        fillCircle(points[i].x, points[i].y, (width - 1) / 2, color);
+    }
+}
+
+// Rows mask of the viewport span y0..y1 clipped to the clip rectangle, 0 when it is outside
+template<class Layout>
+uint64_t Canvas<Layout>::spanMask(int y0, int y1) const {
+
+    if(y0 > y1) std::swap(y0, y1);
+
+    y0 = std::max(y0 + this->view.y, this->view.y0);
+    y1 = std::min(y1 + this->view.y, this->view.y1);
+
+    if(y0 > y1) {
+        return 0;
+    }
+    return (~0ULL >> (63 - (y1 - y0))) << y0;
+}
+
+// Applies the same rows mask to the viewport columns x0..x1, one masked
+// operation per column instead of a bounds checked write per pixel. The
+// rows come from spanMask and are already clipped.
+template<class Layout>
+void Canvas<Layout>::fillColumns(int x0, int x1, uint64_t rows, int color) {
+
+    if(x0 > x1) std::swap(x0, x1);
+
+    x0 = std::max(x0 + this->view.x, this->view.x0);
+    x1 = std::min(x1 + this->view.x, this->view.x1);
+
+    if(x0 > x1 || !rows) {
+        return;
+    }
+
+    if(color) {
+        for(int col = x0; col <= x1; col++) {
+            this->buffer.orColumn(col, rows);
+        }
+    }
+    else {
+        for(int col = x0; col <= x1; col++) {
+            this->buffer.andNotColumn(col, rows);
+        }
+    }
+    markDirty(x0, x1, rows);
+}
+
+template<class Layout>
+void Canvas<Layout>::drawHrzLine(int x0, int x1, int y, int color) {
+    fillColumns(x0, x1, spanMask(y, y), color);
+}
+
+template<class Layout>
+void Canvas<Layout>::drawVertLine(int y0, int y1, int x, int color) {
+    fillColumns(x, x, spanMask(y0, y1), color);
+}
+
+template<class Layout>
+void Canvas<Layout>::drawRectangle(int x0, int y0, int x1, int y1, int color) {
+    drawHrzLine(x0, x1, y0, color);
+    drawHrzLine(x0, x1, y1, color);
+    drawVertLine(y0, y1, x0, color);
+    drawVertLine(y0, y1, x1, color);
+}
+
+template<class Layout>
+void Canvas<Layout>::fillRectangle(int x0, int y0, int x1, int y1, int color) {
+    fillColumns(x0, x1, spanMask(y0, y1), color);
+}
+
+template<class Layout>
+void Canvas<Layout>::drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, int width, int color) {
+    drawPolygon({{x0, y0}, {x1, y1}, {x2, y2}}, width, color);
+}
+
+template<class Layout>
+void Canvas<Layout>::fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, int color) {
+    const Point corners[] = {{x0, y0}, {x1, y1}, {x2, y2}};
+    fillConvex(corners, 3, color);
+}
+
+template<class Layout>
+void Canvas<Layout>::drawEqTriangle(int tipX, int tipY, int height, int width, int color) {
+
+    const int halfBase = 1732 * height / 2000;
+
+    drawTriangle(tipX, tipY, tipX - halfBase, tipY + height, tipX + halfBase, tipY + height, width, color);
+}
+
+// Outline of the midpoint circle, the points of each column are gathered
+// into one mask so every column is written once
+template<class Layout>
+void Canvas<Layout>::drawCircle(int x, int y, int radius, int color) {
+
+    if(radius < 0) {
+        return;
+    }
+    x += this->view.x;
+    y += this->view.y;
+
+    const int first = std::max(x - radius, this->view.x0);
+    const int last = std::min(x + radius, this->view.x1);
+
+    if(first > last) {
+        return;
+    }
+
+    uint64_t masks[WIDTH];
+    std::fill(masks + first, masks + last + 1, 0);
+
+    traceCircle(x, y, radius, 0xF, first, last, masks);
+    applyColumns(masks, first, last, color);
+}
+
+// The same disc as the circle outline, filled with one span per column
+template<class Layout>
+void Canvas<Layout>::fillCircle(int x, int y, int radius, int color) {
+
+    if(radius < 0) {
+        return;
+    }
+    x += this->view.x;
+    y += this->view.y;
+
+    const int first = std::max(x - radius, this->view.x0);
+    const int last = std::min(x + radius, this->view.x1);
+
+    if(first > last) {
+        return;
+    }
+
+    int top[WIDTH];
+    int bottom[WIDTH];
+    std::fill(top + first, top + last + 1, HEIGHT);
+    std::fill(bottom + first, bottom + last + 1, -1);
+
+    traceDisc(x, y, radius, first, last, top, bottom);
+    fillTraced(top, bottom, first, last, color);
+}
+
+// sin() of 0 - 90 degrees scaled to 1024
+static const int16_t SINE_Q10[91] = {
+    0, 18, 36, 54, 71, 89, 107, 125, 143, 160, 178, 195, 213,
+    230, 248, 265, 282, 299, 316, 333, 350, 367, 384, 400, 416, 433,
+    449, 465, 481, 496, 512, 527, 543, 558, 573, 587, 602, 616, 630,
+    644, 658, 672, 685, 698, 711, 724, 737, 749, 761, 773, 784, 796,
+    807, 818, 828, 839, 849, 859, 868, 878, 887, 896, 904, 912, 920,
+    928, 935, 943, 949, 956, 962, 968, 974, 979, 984, 989, 994, 998,
+    1002, 1005, 1008, 1011, 1014, 1016, 1018, 1020, 1022, 1023, 1023, 1024, 1024
+};
+
+// sin() of a whole number of degrees scaled to 1024, any angle
+template<class Layout>
+int Canvas<Layout>::sineQ10(int degrees) {
+
+    degrees = ((degrees % 360) + 360) % 360;
+
+    if(degrees <= 90) return SINE_Q10[degrees];
+    if(degrees <= 180) return SINE_Q10[180 - degrees];
+    if(degrees <= 270) return -SINE_Q10[degrees - 180];
+    return -SINE_Q10[360 - degrees];
+}
+
+// Ring between the radius and radius - width + 1 from startAngle
+// counterclockwise to endAngle. Angles are in degrees with 0 at three
+// o'clock, a sweep of 360 or more draws the whole ring and an empty sweep
+// nothing. The ring is the disc
+// of the radius without the inner disc, so each column is one or two spans;
+// only a partial sweep tests pixels against the two end directions, with
+// integer cross products.
+template<class Layout>
+void Canvas<Layout>::drawArc(int x, int y, int radius, int startAngle, int endAngle, int width, int color) {
+
+    if(radius < 0 || width <= 0) {
+        return;
+    }
+    x += this->view.x;
+    y += this->view.y;
+
+    const int first = std::max(x - radius, this->view.x0);
+    const int last = std::min(x + radius, this->view.x1);
+
+    if(first > last) {
+        return;
+    }
+
+    int outerTop[WIDTH], outerBottom[WIDTH];
+    int innerTop[WIDTH], innerBottom[WIDTH];
+    std::fill(outerTop + first, outerTop + last + 1, HEIGHT);
+    std::fill(outerBottom + first, outerBottom + last + 1, -1);
+    std::fill(innerTop + first, innerTop + last + 1, HEIGHT);
+    std::fill(innerBottom + first, innerBottom + last + 1, -1);
+
+    traceDisc(x, y, radius, first, last, outerTop, outerBottom);
+    if(radius - width >= 0) {
+        traceDisc(x, y, radius - width, first, last, innerTop, innerBottom);
+    }
+
+    const int sweep = endAngle - startAngle;
+    if(sweep == 0) {
+        return;
+    }
+    const bool whole = sweep >= 360 || sweep <= -360;
+    const int arc = ((sweep % 360) + 360) % 360;
+
+    // End directions scaled to 1024 from the sine table, y grows upwards
+    const int64_t sx = sineQ10(startAngle + 90);
+    const int64_t sy = sineQ10(startAngle);
+    const int64_t ex = sineQ10(endAngle + 90);
+    const int64_t ey = sineQ10(endAngle);
+
+    uint64_t masks[WIDTH];
+
+    for(int col = first; col <= last; col++) {
+
+        uint64_t ring = panelRows(outerTop[col], outerBottom[col]) & ~panelRows(innerTop[col], innerBottom[col]);
+
+        if(!whole) {
+            const int64_t dx = col - x;
+            uint64_t rows = ring;
+            ring = 0;
+
+            while(rows) {
+                const int row = __builtin_ctzll(rows);
+                rows &= rows - 1;
+
+                const int64_t dy = y - row;
+                const int64_t fromStart = sx * dy - sy * dx;
+                const int64_t toEnd = dx * ey - dy * ex;
+                const bool inside = (arc <= 180) ? (fromStart >= 0 && toEnd >= 0) : (fromStart >= 0 || toEnd >= 0);
+
+                if(inside) {
+                    ring |= 1ULL << row;
+                }
+            }
+        }
+        masks[col] = ring;
+    }
+    applyColumns(masks, first, last, color);
+}
+
+// Rectangle with quarter circle corners, the radius is limited to half the
+// shorter side
+template<class Layout>
+void Canvas<Layout>::drawRoundRect(int x0, int y0, int x1, int y1, int radius, int color) {
+
+    if(x0 > x1) std::swap(x0, x1);
+    if(y0 > y1) std::swap(y0, y1);
+    radius = std::max(0, std::min(radius, std::min(x1 - x0, y1 - y0) / 2));
+
+    x0 += this->view.x;
+    x1 += this->view.x;
+    y0 += this->view.y;
+    y1 += this->view.y;
+
+    const int first = std::max(x0, this->view.x0);
+    const int last = std::min(x1, this->view.x1);
+
+    if(first > last) {
+        return;
+    }
+
+    uint64_t masks[WIDTH];
+    const uint64_t edges = panelRows(y0, y0) | panelRows(y1, y1);
+    const uint64_t sides = panelRows(y0 + radius, y1 - radius);
+
+    for(int col = first; col <= last; col++) {
+        masks[col] = (col >= x0 + radius && col <= x1 - radius) ? edges : 0;
+    }
+    if(first == x0) masks[x0] |= sides;
+    if(last == x1) masks[x1] |= sides;
+
+    traceCircle(x1 - radius, y0 + radius, radius, 1, first, last, masks);
+    traceCircle(x0 + radius, y0 + radius, radius, 2, first, last, masks);
+    traceCircle(x0 + radius, y1 - radius, radius, 4, first, last, masks);
+    traceCircle(x1 - radius, y1 - radius, radius, 8, first, last, masks);
+
+    applyColumns(masks, first, last, color);
+}
+
+template<class Layout>
+void Canvas<Layout>::fillRoundRect(int x0, int y0, int x1, int y1, int radius, int color) {
+
+    if(x0 > x1) std::swap(x0, x1);
+    if(y0 > y1) std::swap(y0, y1);
+    radius = std::max(0, std::min(radius, std::min(x1 - x0, y1 - y0) / 2));
+
+    x0 += this->view.x;
+    x1 += this->view.x;
+    y0 += this->view.y;
+    y1 += this->view.y;
+
+    const int first = std::max(x0, this->view.x0);
+    const int last = std::min(x1, this->view.x1);
+
+    if(first > last) {
+        return;
+    }
+
+    // Full height between the corners, the corner discs above and below the sides
+    int top[WIDTH];
+    int bottom[WIDTH];
+
+    for(int col = first; col <= last; col++) {
+        const bool middle = col >= x0 + radius && col <= x1 - radius;
+        top[col] = middle ? y0 : y0 + radius;
+        bottom[col] = middle ? y1 : y1 - radius;
+    }
+    traceDisc(x0 + radius, y0 + radius, radius, first, last, top, bottom);
+    traceDisc(x1 - radius, y0 + radius, radius, first, last, top, bottom);
+    traceDisc(x0 + radius, y1 - radius, radius, first, last, top, bottom);
+    traceDisc(x1 - radius, y1 - radius, radius, first, last, top, bottom);
+
+    fillTraced(top, bottom, first, last, color);
+}
+
+template<class Layout>
+void Canvas<Layout>::draw_64(uint64_t* bitmap) {
+    blitColumns(bitmap, WIDTH, HEIGHT, 0, 0, ROP_COPY);
+}
+
+// Draws a bitmap with its top left corner at (x, y), clipped on all edges
+template<class Layout>
+void Canvas<Layout>::blit(const Bitmap& bitmap, int x, int y, RasterOp op) {
+    blitColumns(bitmap.data(), bitmap.getWidth(), bitmap.getHeight(), x, y, op);
+}
+
+// Draws width columns of height rows each at (x, y). Every column is shifted
+// to y and combined with the canvas through one mask, rows past the height
+// are ignored.
+template<class Layout>
+void Canvas<Layout>::blitColumns(const uint64_t* columns, int width, int height, int x, int y, RasterOp op) {
+
+    x += this->view.x;
+    y += this->view.y;
+
+    const int x0 = std::max(x, this->view.x0);
+    const int x1 = std::min(x + width - 1, this->view.x1);
+
+    if(x0 > x1 || height <= 0 || y >= HEIGHT || y <= -height) {
+        return;
+    }
+
+    // Rows covered by the columns after the shift, clipped to the canvas
+    const uint64_t rows = (height >= 64) ? ~0ULL : ~0ULL >> (64 - height);
+    const uint64_t mask = ((y >= 0) ? rows << y : rows >> -y) & this->clipRows;
+
+    for(int col = x0; col <= x1; col++) {
+
+        uint64_t bits = columns[col - x];
+        bits = ((y >= 0) ? bits << y : bits >> -y) & mask;
+
+        switch(op) {
+            case ROP_COPY:
+                this->buffer.setColumn(col, (this->buffer.column(col) & ~mask) | bits);
+                break;
+            case ROP_OR:
+                this->buffer.orColumn(col, bits);
+                break;
+            case ROP_AND_NOT:
+                this->buffer.andNotColumn(col, bits);
+                break;
+            case ROP_XOR:
+                this->buffer.xorColumn(col, bits);
+                break;
+        }
+    }
+    markDirty(x0, x1, mask);
+}
+
+// Copies a PBM or PGM image with its top left corner at (x, y). Only the
+// part inside the clip rectangle is read from the image, gray images are
+// dithered with the mode.
+template<class Layout>
+void Canvas<Layout>::drawImage(const PnmImage& image, int x, int y, DitherMode mode) {
+
+    const int left = std::max(x + this->view.x, this->view.x0);
+    const int top = std::max(y + this->view.y, this->view.y0);
+    const int right = std::min(x + this->view.x + image.getWidth() - 1, this->view.x1);
+    const int bottom = std::min(y + this->view.y + image.getHeight() - 1, this->view.y1);
+
+    if(left > right || top > bottom) {
+        return;
+    }
+
+    const int width = right - left + 1;
+    const int height = bottom - top + 1;
+    uint64_t columns[WIDTH];
+
+    image.readColumns(left - this->view.x - x, top - this->view.y - y, width, height, columns, mode);
+    blitColumns(columns, width, height, left - this->view.x, top - this->view.y, ROP_COPY);
+}
+
+// Erases the sprite at its old position and draws it at the new one, only
+// the columns of the two footprints are touched and marked dirty. XOR sprites
+// are erased by drawing them again and keep what is under them, the others
+// clear their rectangle (set it for ROP_AND_NOT). Sprite positions are canvas
+// coordinates and ignore the viewport, so a sprite is always erased exactly
+// where it was drawn.
+template<class Layout>
+void Canvas<Layout>::moveSprite(Sprite& sprite, int x, int y) {
+
+    if(sprite.isVisible()) {
+        drawSprite(sprite, true);
+    }
+    sprite.setPosition(x, y);
+    drawSprite(sprite, false);
+    sprite.setVisible(true);
+}
+
+template<class Layout>
+void Canvas<Layout>::hideSprite(Sprite& sprite) {
+
+    if(sprite.isVisible()) {
+        drawSprite(sprite, true);
+        sprite.setVisible(false);
+    }
+}
+
+// Draws or erases a sprite at its position with the cached shifted columns
+template<class Layout>
+void Canvas<Layout>::drawSprite(Sprite& sprite, bool erase) {
+
+    const int x = sprite.getX();
+    const int y = sprite.getY();
+    const int x0 = std::max(x, 0);
+    const int x1 = std::min(x + sprite.getWidth() - 1, WIDTH - 1);
+
+    if(x0 > x1 || y >= HEIGHT || y <= -sprite.getHeight()) {
+        return;
+    }
+
+    const uint64_t mask = sprite.mask(y) & (~0ULL >> (64 - HEIGHT));
+    const uint64_t* bits = sprite.columns(y);
+    const RasterOp op = sprite.getOp();
+
+    for(int col = x0; col <= x1; col++) {
+
+        if(op == ROP_XOR) {
+            this->buffer.xorColumn(col, bits[col - x] & mask);
+        }
+        else if(erase) {
+            (op == ROP_AND_NOT) ? this->buffer.orColumn(col, mask) : this->buffer.andNotColumn(col, mask);
+        }
+        else if(op == ROP_COPY) {
+            this->buffer.setColumn(col, (this->buffer.column(col) & ~mask) | (bits[col - x] & mask));
+        }
+        else if(op == ROP_OR) {
+            this->buffer.orColumn(col, bits[col - x] & mask);
+        }
+        else {
+            this->buffer.andNotColumn(col, bits[col - x] & mask);
+        }
+    }
+    markDirty(x0, x1, mask);
+}
+
+// Glyph of a character in the built-in 6x8 font, 8 column bytes
+template<class Layout>
+const uint8_t* Canvas<Layout>::ASCIImap(char c) {
+    return Font6x8::glyph(c);
+}
+
+// Surfaces the driver is built for, any of them can be used offscreen
+template class Canvas<ColumnMajor<128, 64>>;
+template class Canvas<ColumnMajor<128, 32>>;
+template class Canvas<ColumnMajor<96, 16>>;
+template class Canvas<ColumnMajor<64, 48>>;
+template class Canvas<PageMajor<128, 64>>;
+template class Canvas<PageMajor<128, 32>>;
+template class Canvas<PageMajor<96, 16>>;
+template class Canvas<PageMajor<64, 48>>;
+template class Canvas<QuarterTurn<ColumnMajor<48, 64>>>;
+template class Canvas<QuarterTurn<PageMajor<48, 64>>>;
@@ -0,0 +1,290 @@
+/*
+    SSD1306_emulator.cpp
+
+*/
+#include "SSD1306_emulator.h"
+
+SSD1306Emulator::SSD1306Emulator() : opened(false), connected(true), commandBytes(0), dataBytes(0) {
+    powerOn();
+}
+
+SSD1306Emulator::~SSD1306Emulator() {
+}
+
+bool SSD1306Emulator::open() {
+    this->opened = true;
+    return true;
+}
+
+void SSD1306Emulator::close() {
+    this->opened = false;
+    discard();
+}
+
+bool SSD1306Emulator::isOpen() const {
+    return this->opened;
+}
+
+// Reset state of the controller. GRAM content is undefined after power up,
+// it is filled with a noise pattern so missing writes show up.
+void SSD1306Emulator::powerOn() {
+
+    uint32_t noise = 0x2545F491;
+    for(int page = 0; page < EMU_PAGES; page++) {
+        for(int c = 0; c < EMU_COLUMNS; c++) {
+            noise ^= noise << 13;
+            noise ^= noise >> 17;
+            noise ^= noise << 5;
+            this->gram[page][c] = noise & 0xFF;
+        }
+    }
+
+    this->commandLen = 0;
+    this->commandArgs = 0;
+    this->addressingMode = EMU_PAGE_ADDRESSING;
+    this->colStart = 0;
+    this->colEnd = EMU_COLUMNS - 1;
+    this->pageStart = 0;
+    this->pageEnd = EMU_PAGES - 1;
+    this->col = 0;
+    this->page = 0;
+    this->startLine = 0;
+    this->displayOffset = 0;
+    this->multiplex = EMU_ROWS - 1;
+    this->contrast = 0x7F;
+    this->inverse = false;
+    this->displayOn = false;
+    this->entireOn = false;
+    this->segRemap = false;
+    this->comReverse = false;
+    this->scrolling = false;
+}
+
+// Simulates unplugging the display, transfers fail like a NACKed address.
+// Plugging it back in powers the controller up again in its reset state.
+void SSD1306Emulator::setConnected(bool is_connected) {
+
+    if(is_connected && !this->connected) {
+        powerOn();
+    }
+    this->connected = is_connected;
+}
+
+// Decodes every message like the controller does: a control byte with the
+// continuation bit set covers one byte, without it the rest of the message.
+int SSD1306Emulator::submit(const std::vector<Message>& messages) {
+
+    if(!this->opened) {
+        return -EBADF;
+    }
+    if(!this->connected) {
+        return -EREMOTEIO;
+    }
+
+    for(const Message& msg : messages) {
+
+        const uint8_t* buf = messageBuffer(msg);
+        size_t index = 0;
+
+        while(index < msg.len) {
+
+            uint8_t control = buf[index++];
+            bool is_data = control & CTRL_DATA;
+            size_t end = (control & CTRL_CONTINUATION) ? std::min(index + 1, msg.len) : msg.len;
+
+            for(; index < end; index++) {
+                is_data ? dataByte(buf[index]) : commandByte(buf[index]);
+            }
+        }
+    }
+    return 0;
+}
+
+// Number of argument bytes following each command
+static int commandArgCount(uint8_t command) {
+
+    switch(command) {
+        case 0x81: case 0x20: case 0xA8: case 0xD3: case 0xD5:
+        case 0xD9: case 0xDA: case 0xDB: case 0x8D:
+            return 1;
+        case 0x21: case 0x22: case 0xA3:
+            return 2;
+        case 0x29: case 0x2A:
+            return 5;
+        case 0x26: case 0x27:
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+void SSD1306Emulator::commandByte(uint8_t byte) {
+
+    this->commandBytes++;
+
+    if(this->commandLen == 0) {
+        this->commandArgs = commandArgCount(byte);
+    }
+    this->command[this->commandLen++] = byte;
+
+    if(this->commandLen > this->commandArgs) {
+        executeCommand();
+        this->commandLen = 0;
+    }
+}
+
+void SSD1306Emulator::executeCommand() {
+
+    uint8_t cmd = this->command[0];
+
+    if(cmd <= 0x0F) {
+        this->col = (this->col & 0xF0) | cmd;                   // Lower column start, page addressing
+    }
+    else if(cmd <= 0x1F) {
+        this->col = (this->col & 0x0F) | ((cmd & 0x07) << 4);   // Higher column start, page addressing
+    }
+    else if(cmd >= 0x40 && cmd <= 0x7F) {
+        this->startLine = cmd & 0x3F;
+    }
+    else if(cmd >= 0xB0 && cmd <= 0xB7) {
+        this->page = cmd & 0x07;
+    }
+    else {
+        switch(cmd) {
+            case 0x20: this->addressingMode = this->command[1] & 0x03; break;
+            case 0x21:
+                this->colStart = this->command[1] & 0x7F;
+                this->colEnd = this->command[2] & 0x7F;
+                this->col = this->colStart;
+                break;
+            case 0x22:
+                this->pageStart = this->command[1] & 0x07;
+                this->pageEnd = this->command[2] & 0x07;
+                this->page = this->pageStart;
+                break;
+            case 0x81: this->contrast = this->command[1]; break;
+            case 0xA0: this->segRemap = false; break;
+            case 0xA1: this->segRemap = true; break;
+            case 0xA4: this->entireOn = false; break;
+            case 0xA5: this->entireOn = true; break;
+            case 0xA6: this->inverse = false; break;
+            case 0xA7: this->inverse = true; break;
+            case 0xA8: this->multiplex = this->command[1] & 0x3F; break;
+            case 0xAE: this->displayOn = false; break;
+            case 0xAF: this->displayOn = true; break;
+            case 0xC0: this->comReverse = false; break;
+            case 0xC8: this->comReverse = true; break;
+            case 0xD3: this->displayOffset = this->command[1] & 0x3F; break;
+            case 0x2E: this->scrolling = false; break;
+            case 0x2F: this->scrolling = true; break;
+            default: break;
+        }
+    }
+}
+
+// Writes one byte at the GRAM pointer and advances it according to the addressing mode
+void SSD1306Emulator::dataByte(uint8_t byte) {
+
+    this->dataBytes++;
+    this->gram[this->page][this->col] = byte;
+
+    switch(this->addressingMode) {
+        case EMU_HOR_ADDRESSING:
+            if(++this->col > this->colEnd) {
+                this->col = this->colStart;
+                if(++this->page > this->pageEnd) {
+                    this->page = this->pageStart;
+                }
+            }
+            break;
+        case EMU_VER_ADDRESSING:
+            if(++this->page > this->pageEnd) {
+                this->page = this->pageStart;
+                if(++this->col > this->colEnd) {
+                    this->col = this->colStart;
+                }
+            }
+            break;
+        default:
+            this->col = (this->col + 1) % EMU_COLUMNS;
+            break;
+    }
+}
+
+bool SSD1306Emulator::gramPixel(int col, int row) const {
+
+    if(col < 0 || col >= EMU_COLUMNS || row < 0 || row >= EMU_ROWS) {
+        return false;
+    }
+    return (this->gram[row >> 3][col] >> (row & 7)) & 1;
+}
+
+// Pixel as seen on the panel, with the driver's default segment remap and COM
+// scan direction (0xA1, 0xC8) being the upright orientation
+bool SSD1306Emulator::displayPixel(int x, int y) const {
+
+    if(x < 0 || x >= EMU_COLUMNS || y < 0 || y > this->multiplex) {
+        return false;
+    }
+    if(!this->displayOn) {
+        return false;
+    }
+    if(this->entireOn) {
+        return true;
+    }
+
+    int gram_col = this->segRemap ? x : (EMU_COLUMNS - 1 - x);
+    int com = this->comReverse ? y : (this->multiplex - y);
+    int gram_row = (com + this->startLine + this->displayOffset) % EMU_ROWS;
+
+    return gramPixel(gram_col, gram_row) != this->inverse;
+}
+
+// Copies the panel image into column-major words, one uint64_t per column
+void SSD1306Emulator::readDisplay(uint64_t* columns) const {
+
+    for(int x = 0; x < EMU_COLUMNS; x++) {
+        columns[x] = 0;
+        for(int y = 0; y < EMU_ROWS; y++) {
+            if(displayPixel(x, y)) {
+                columns[x] |= 1ULL << y;
+            }
+        }
+    }
+}
+
+const uint8_t* SSD1306Emulator::getGram() const {
+    return &this->gram[0][0];
+}
+
+uint64_t SSD1306Emulator::getCommandBytes() const {
+    return this->commandBytes;
+}
+
+uint64_t SSD1306Emulator::getDataBytes() const {
+    return this->dataBytes;
+}
+
+int SSD1306Emulator::getStartLine() const {
+    return this->startLine;
+}
+
+int SSD1306Emulator::getContrast() const {
+    return this->contrast;
+}
+
+bool SSD1306Emulator::isInverse() const {
+    return this->inverse;
+}
+
+bool SSD1306Emulator::isDisplayOn() const {
+    return this->displayOn;
+}
+
+bool SSD1306Emulator::isScrolling() const {
+    return this->scrolling;
+}
+
+int SSD1306Emulator::getAddressingMode() const {
+    return this->addressingMode;
+}
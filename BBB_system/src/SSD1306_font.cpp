@@ -0,0 +1,555 @@
+/*
+    SSD1306_font.cpp
+
+*/
+#include "SSD1306_font.h"
+
+// The one copy of the built-in font tables, glyph() references point into them
+constexpr Glyph Font6x8::glyphs[Font6x8::GLYPHS];
+constexpr Glyph Font6x8::extraGlyphs[Font6x8::EXTRA_GLYPHS];
+constexpr uint16_t Font6x8::latin1[96];
+constexpr Font6x8::Symbol Font6x8::symbols[Font6x8::SYMBOLS];
+
+// Decodes the multibyte sequence at byte i and moves i past it. A sequence
+// that is cut short, overlong, a surrogate or past U+10FFFF decodes to
+// UTF8_REPLACEMENT, consuming the bytes up to where it went wrong so the
+// next character starts on the next possible lead byte.
+uint32_t decodeUTF8(const std::string& text, size_t& i) {
+
+    const unsigned char lead = text[i++];
+    uint32_t code, min;
+    int length;
+
+    if(lead >= 0xC2 && lead <= 0xDF) {
+        code = lead & 0x1F;
+        min = 0x80;
+        length = 1;
+    }
+    else if(lead >= 0xE0 && lead <= 0xEF) {
+        code = lead & 0x0F;
+        min = 0x800;
+        length = 2;
+    }
+    else if(lead >= 0xF0 && lead <= 0xF4) {
+        code = lead & 0x07;
+        min = 0x10000;
+        length = 3;
+    }
+    else {
+        return (lead < 0x80) ? lead : UTF8_REPLACEMENT;
+    }
+
+    for(int k = 0; k < length; k++) {
+        if(i >= text.size() || (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80) {
+            return UTF8_REPLACEMENT;
+        }
+        code = (code << 6) | (static_cast<unsigned char>(text[i++]) & 0x3F);
+    }
+
+    if(code < min || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+        return UTF8_REPLACEMENT;
+    }
+    return code;
+}
+
+// Glyph number of a code point, REPLACEMENT when the font has no glyph for it
+int Font6x8::number(uint32_t code) {
+
+    if(code < 0x80) {
+        return static_cast<int>(code);
+    }
+    if(code >= 0xA0 && code <= 0xFF) {
+        return latin1[code - 0xA0];
+    }
+
+    const Symbol* end = symbols + SYMBOLS;
+    const Symbol* found = std::lower_bound(symbols, end, code,
+        [](const Symbol& symbol, uint32_t code) { return symbol.code < code; });
+
+    return (found != end && found->code == code) ? found->glyph : REPLACEMENT;
+}
+
+// Width of UTF-8 text in pixels, one advance per code point
+int Font6x8::measure(const std::string& text) {
+
+    int width = 0;
+    for(size_t i = 0; i < text.size(); width += ADVANCE) {
+        nextCodePoint(text, i);
+    }
+    return width;
+}
+
+// Start of a font cache file, followed by the glyph and kerning tables and
+// the atlas, each starting at a multiple of 8 bytes
+struct FontCacheHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t height;
+    int32_t ascent;
+    uint32_t fallback;
+    uint32_t glyphs;
+    uint32_t kernings;
+    uint32_t columns;
+};
+
+static const char FONT_CACHE_MAGIC[4] = { 'S', 'F', 'N', 'T' };
+static const uint32_t FONT_CACHE_VERSION = 1;
+
+static size_t align8(size_t bytes) {
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+// Returned for every code point by a font without glyphs
+static const FontGlyph NO_GLYPH = { 0, 0, 0, 0, 0, 0 };
+
+// The built-in 6x8 font as a Font with a 6 pixel advance: printable ASCII,
+// Latin-1, the symbols and the replacement glyph for everything else
+Font::Font() : height(Font6x8::HEIGHT), ascent(Font6x8::HEIGHT), revision(nextRevision()), fallback(UTF8_REPLACEMENT),
+    glyphs(nullptr), glyphCount(0), kernings(nullptr), kerningCount(0), atlas(nullptr), atlasColumns(0), mapped(nullptr), mappedSize(0) {
+
+    auto add = [this](uint32_t code, int number) {
+        uint64_t columns[Font6x8::ADVANCE];
+        for(int col = 0; col < Font6x8::ADVANCE; col++) {
+            columns[col] = Font6x8::numbered(number)[col];
+        }
+        addGlyph(code, columns, Font6x8::ADVANCE, 0, Font6x8::ADVANCE);
+    };
+
+    for(int code = 0x20; code < 0x7F; code++) {
+        add(code, code);
+    }
+    for(int code = 0xA0; code <= 0xFF; code++) {
+        add(code, Font6x8::latin1[code - 0xA0]);
+    }
+    for(const Font6x8::Symbol& symbol : Font6x8::symbols) {
+        add(symbol.code, symbol.glyph);
+    }
+    add(UTF8_REPLACEMENT, Font6x8::REPLACEMENT);
+    finish();
+}
+
+// Font from a BDF file. With a cache path the cache is used when it is at
+// least as new as the BDF file, otherwise the BDF file is parsed and the
+// cache written for the next time.
+Font::Font(const std::string& bdfPath, const std::string& cachePath) : height(0), ascent(0), revision(nextRevision()), fallback('?'),
+    glyphs(nullptr), glyphCount(0), kernings(nullptr), kerningCount(0), atlas(nullptr), atlasColumns(0), mapped(nullptr), mappedSize(0) {
+
+    if(!cachePath.empty()) {
+        struct stat bdf, cache;
+        const bool haveBDF = stat(bdfPath.c_str(), &bdf) == 0;
+
+        if(stat(cachePath.c_str(), &cache) == 0 && (!haveBDF || cache.st_mtime >= bdf.st_mtime) && mapCache(cachePath)) {
+            return;
+        }
+    }
+
+    if(loadBDF(bdfPath) && !cachePath.empty()) {
+        saveCache(cachePath);
+    }
+}
+
+Font::~Font() {
+    if(this->mapped) {
+        munmap(this->mapped, this->mappedSize);
+    }
+}
+
+bool Font::isValid() const {
+    return this->glyphCount > 0;
+}
+
+// Rows of a line of text
+int Font::getHeight() const {
+    return this->height;
+}
+
+// Rows above the baseline
+int Font::getAscent() const {
+    return this->ascent;
+}
+
+// Cached renderings of the font's text are valid while this stays the same
+uint32_t Font::getRevision() const {
+    return this->revision;
+}
+
+uint32_t Font::nextRevision() {
+
+    static std::atomic<uint32_t> revisions(0);
+    return ++revisions;
+}
+
+// Glyph of a code point, the fallback glyph when the font does not have it.
+// ASCII is a table lookup, anything else a binary search.
+const FontGlyph& Font::glyph(uint32_t code) const {
+
+    if(code < 128) {
+        const int index = this->ascii[code];
+        if(index >= 0) {
+            return this->glyphs[index];
+        }
+    }
+    else {
+        const FontGlyph* end = this->glyphs + this->glyphCount;
+        const FontGlyph* found = std::lower_bound(this->glyphs, end, code,
+            [](const FontGlyph& glyph, uint32_t code) { return glyph.code < code; });
+
+        if(found != end && found->code == code) {
+            return *found;
+        }
+    }
+
+    if(code != this->fallback) {
+        return glyph(this->fallback);
+    }
+    return (this->glyphCount > 0) ? this->glyphs[0] : NO_GLYPH;
+}
+
+const uint64_t* Font::columns(const FontGlyph& glyph) const {
+    return this->atlas + glyph.offset;
+}
+
+// Pen adjustment between two consecutive code points
+int Font::kerning(uint32_t left, uint32_t right) const {
+
+    if(this->kerningCount == 0) {
+        return 0;
+    }
+
+    const FontKerning* end = this->kernings + this->kerningCount;
+    const FontKerning* found = std::lower_bound(this->kernings, end, FontKerning{left, right, 0},
+        [](const FontKerning& a, const FontKerning& b) { return a.left < b.left || (a.left == b.left && a.right < b.right); });
+
+    if(found != end && found->left == left && found->right == right) {
+        return found->offset;
+    }
+    return 0;
+}
+
+// Adds or replaces a kerning pair, a mapped font is copied out of the cache first
+void Font::setKerning(uint32_t left, uint32_t right, int offset) {
+
+    own();
+
+    auto before = [](const FontKerning& a, const FontKerning& b) { return a.left < b.left || (a.left == b.left && a.right < b.right); };
+    const FontKerning pair = { left, right, offset };
+    auto found = std::lower_bound(this->ownKernings.begin(), this->ownKernings.end(), pair, before);
+
+    if(found != this->ownKernings.end() && found->left == left && found->right == right) {
+        found->offset = offset;
+    }
+    else {
+        this->ownKernings.insert(found, pair);
+    }
+    this->kernings = this->ownKernings.data();
+    this->kerningCount = this->ownKernings.size();
+    this->revision = nextRevision();
+}
+
+// Width of the text in pixels, the sum of the advances and kerning
+int Font::measure(const std::string& text) const {
+
+    int width = 0;
+    uint32_t previous = 0;
+
+    for(size_t i = 0; i < text.size(); ) {
+        const size_t start = i;
+        const uint32_t code = nextCodePoint(text, i);
+        if(start > 0) {
+            width += kerning(previous, code);
+        }
+        width += glyph(code).advance;
+        previous = code;
+    }
+    return width;
+}
+
+// Length in bytes of the leading characters of the text that fit in width
+// pixels, the text is never cut inside a UTF-8 sequence
+size_t Font::fit(const std::string& text, int width) const {
+
+    int pen = 0;
+    uint32_t previous = 0;
+
+    for(size_t i = 0; i < text.size(); ) {
+        const size_t start = i;
+        const uint32_t code = nextCodePoint(text, i);
+        if(start > 0) {
+            pen += kerning(previous, code);
+        }
+        pen += glyph(code).advance;
+
+        if(pen > width) {
+            return start;
+        }
+        previous = code;
+    }
+    return text.size();
+}
+
+// Writes the tables as they are in memory, so mapCache() can use the file in
+// place. The file is written next to the cache and renamed over it, a font
+// mapping the old cache keeps its copy.
+bool Font::saveCache(const std::string& path) const {
+
+    if(!isValid()) {
+        return false;
+    }
+
+    const FontCacheHeader header = {
+        { FONT_CACHE_MAGIC[0], FONT_CACHE_MAGIC[1], FONT_CACHE_MAGIC[2], FONT_CACHE_MAGIC[3] },
+        FONT_CACHE_VERSION, this->height, this->ascent, this->fallback,
+        static_cast<uint32_t>(this->glyphCount), static_cast<uint32_t>(this->kerningCount),
+        static_cast<uint32_t>(this->atlasColumns)
+    };
+
+    const char padding[8] = {};
+    const std::string temporary = path + ".tmp";
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+
+    auto write = [&](const void* data, size_t bytes) {
+        file.write(static_cast<const char*>(data), bytes);
+        file.write(padding, align8(bytes) - bytes);
+    };
+
+    write(&header, sizeof(header));
+    write(this->glyphs, this->glyphCount * sizeof(FontGlyph));
+    write(this->kernings, this->kerningCount * sizeof(FontKerning));
+    write(this->atlas, this->atlasColumns * sizeof(uint64_t));
+
+    file.close();
+
+    if(!file || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to write font cache " << path << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Reads a BDF font: the ascent and descent, then every glyph with an
+// encoding, its advance, bounding box and hex bitmap rows. Glyph rows are
+// placed on the line by the bounding box, columns left of the pen by its
+// x offset.
+bool Font::loadBDF(const std::string& path) {
+
+    std::ifstream file(path);
+    if(!file) {
+        std::cerr << "Failed to open font " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    int descent = -1;
+    int boxHeight = 0, boxY = 0;
+    this->ascent = -1;
+
+    // Glyph being read
+    long code = -1;
+    int advance = 0;
+    int width = 0, rows = 0, left = 0, bottom = 0;
+    std::vector<uint64_t> columns;
+
+    std::string line;
+    while(std::getline(file, line)) {
+
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+
+        if(key == "FONTBOUNDINGBOX") {
+            int boxWidth, boxX;
+            fields >> boxWidth >> boxHeight >> boxX >> boxY;
+        }
+        else if(key == "FONT_ASCENT") {
+            fields >> this->ascent;
+        }
+        else if(key == "FONT_DESCENT") {
+            fields >> descent;
+        }
+        else if(key == "DEFAULT_CHAR") {
+            fields >> this->fallback;
+        }
+        else if(key == "STARTCHAR") {
+            code = -1;
+            advance = width = rows = left = bottom = 0;
+        }
+        else if(key == "ENCODING") {
+            fields >> code;
+        }
+        else if(key == "DWIDTH") {
+            fields >> advance;
+        }
+        else if(key == "BBX") {
+            fields >> width >> rows >> left >> bottom;
+        }
+        else if(key == "BITMAP") {
+
+            // The line size is known once the properties are read
+            if(this->height == 0) {
+                if(this->ascent < 0) this->ascent = boxHeight + boxY;
+                if(descent < 0) descent = -boxY;
+                this->height = this->ascent + descent;
+
+                if(this->height <= 0 || this->height > 64) {
+                    std::cerr << "Font height " << this->height << " out of range, has to be 1 - 64" << std::endl;
+                    this->height = 0;
+                    return false;
+                }
+            }
+
+            columns.assign(std::max(width, 0), 0);
+            const int top = this->ascent - bottom - rows;
+
+            for(int row = 0; row < rows && std::getline(file, line); row++) {
+
+                const int y = top + row;
+                if(y < 0 || y >= this->height) {
+                    continue;
+                }
+                for(int col = 0; col < width && static_cast<size_t>(col / 4) < line.size(); col++) {
+                    const char digit = line[col / 4];
+                    const int nibble = isdigit(digit) ? digit - '0' : isxdigit(digit) ? (toupper(digit) - 'A' + 10) : 0;
+                    if((nibble >> (3 - col % 4)) & 1) {
+                        columns[col] |= 1ULL << y;
+                    }
+                }
+            }
+
+            // A glyph with a malformed bounding box is left out
+            if(code >= 0 && code <= 0x10FFFF && width >= 0 && width <= 255 && rows >= 0) {
+                addGlyph(static_cast<uint32_t>(code), columns.data(), width, left, advance);
+            }
+        }
+    }
+
+    if(this->ownGlyphs.empty()) {
+        std::cerr << "No glyphs in font " << path << std::endl;
+        return false;
+    }
+    finish();
+    return true;
+}
+
+// Uses a cache file written by saveCache() in place
+bool Font::mapCache(const std::string& path) {
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    void* map = MAP_FAILED;
+    if(fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(FontCacheHeader)) {
+        map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if(map == MAP_FAILED) {
+        return false;
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(map);
+    const FontCacheHeader* header = reinterpret_cast<const FontCacheHeader*>(data);
+    const size_t size = info.st_size;
+
+    // Table sizes are checked one by one first so the offsets can't overflow
+    bool valid = std::memcmp(header->magic, FONT_CACHE_MAGIC, 4) == 0 && header->version == FONT_CACHE_VERSION
+        && header->height > 0 && header->height <= 64 && header->glyphs > 0
+        && header->glyphs <= size / sizeof(FontGlyph) && header->kernings <= size / sizeof(FontKerning)
+        && header->columns <= size / sizeof(uint64_t);
+
+    const size_t glyphsAt = align8(sizeof(FontCacheHeader));
+    const size_t kerningsAt = glyphsAt + align8(header->glyphs * sizeof(FontGlyph));
+    const size_t atlasAt = kerningsAt + align8(header->kernings * sizeof(FontKerning));
+
+    valid = valid && atlasAt <= size && header->columns <= (size - atlasAt) / sizeof(uint64_t);
+
+    // A damaged atlas offset would read past the mapping
+    const FontGlyph* glyphs = reinterpret_cast<const FontGlyph*>(data + glyphsAt);
+    for(size_t i = 0; valid && i < header->glyphs; i++) {
+        valid = glyphs[i].offset <= header->columns && glyphs[i].width <= header->columns - glyphs[i].offset;
+    }
+
+    // Nothing is taken from a cache that fails, the font is read again from a clean state
+    if(!valid) {
+        std::cerr << "Invalid font cache " << path << ", reading the font again" << std::endl;
+        munmap(map, info.st_size);
+        return false;
+    }
+
+    this->height = header->height;
+    this->ascent = header->ascent;
+    this->fallback = header->fallback;
+    this->glyphs = glyphs;
+    this->glyphCount = header->glyphs;
+    this->kernings = reinterpret_cast<const FontKerning*>(data + kerningsAt);
+    this->kerningCount = header->kernings;
+    this->atlas = reinterpret_cast<const uint64_t*>(data + atlasAt);
+    this->atlasColumns = header->columns;
+    this->mapped = map;
+    this->mappedSize = info.st_size;
+
+    finish();
+    return true;
+}
+
+// Appends a glyph to the owned tables, blank columns at either side are
+// left out of the atlas and only move the first column
+void Font::addGlyph(uint32_t code, const uint64_t* columns, int width, int left, int advance) {
+
+    int first = 0, last = width - 1;
+    while(first <= last && columns[first] == 0) first++;
+    while(last >= first && columns[last] == 0) last--;
+
+    FontGlyph glyph;
+    glyph.code = code;
+    glyph.offset = static_cast<uint32_t>(this->ownAtlas.size());
+    glyph.left = static_cast<int8_t>(std::max(-128, std::min(127, left + ((first <= last) ? first : 0))));
+    glyph.width = static_cast<uint8_t>(last - first + 1);
+    glyph.advance = static_cast<uint8_t>(std::max(0, std::min(255, advance)));
+    glyph.spare = 0;
+
+    this->ownAtlas.insert(this->ownAtlas.end(), columns + first, columns + last + 1);
+    this->ownGlyphs.push_back(glyph);
+}
+
+// Sorts the owned glyphs by code, dropping repeated codes, and builds the
+// ASCII lookup table of whichever tables are in use
+void Font::finish() {
+
+    if(!this->mapped) {
+        std::stable_sort(this->ownGlyphs.begin(), this->ownGlyphs.end(),
+            [](const FontGlyph& a, const FontGlyph& b) { return a.code < b.code; });
+        this->ownGlyphs.erase(std::unique(this->ownGlyphs.begin(), this->ownGlyphs.end(),
+            [](const FontGlyph& a, const FontGlyph& b) { return a.code == b.code; }), this->ownGlyphs.end());
+
+        this->glyphs = this->ownGlyphs.data();
+        this->glyphCount = this->ownGlyphs.size();
+        this->kernings = this->ownKernings.data();
+        this->kerningCount = this->ownKernings.size();
+        this->atlas = this->ownAtlas.data();
+        this->atlasColumns = this->ownAtlas.size();
+    }
+
+    std::fill(this->ascii, this->ascii + 128, -1);
+    for(size_t i = 0; i < this->glyphCount && this->glyphs[i].code < 128; i++) {
+        this->ascii[this->glyphs[i].code] = static_cast<int16_t>(i);
+    }
+}
+
+// Copies the tables out of the cache mapping so they can be changed
+void Font::own() {
+
+    if(!this->mapped) {
+        return;
+    }
+
+    this->ownGlyphs.assign(this->glyphs, this->glyphs + this->glyphCount);
+    this->ownKernings.assign(this->kernings, this->kernings + this->kerningCount);
+    this->ownAtlas.assign(this->atlas, this->atlas + this->atlasColumns);
+
+    munmap(this->mapped, this->mappedSize);
+    this->mapped = nullptr;
+    finish();
+}
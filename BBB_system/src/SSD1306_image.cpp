@@ -0,0 +1,191 @@
+/*
+    SSD1306_image.cpp
+
+*/
+#include "SSD1306_image.h"
+
+// Black image
+GrayImage::GrayImage(int width, int height) : width(std::max(width, 0)), height(std::max(height, 0)) {
+    this->pixels.assign(static_cast<size_t>(this->width) * this->height, 0);
+}
+
+// Copy of a raw 8-bit buffer, stride is the distance between rows in bytes
+GrayImage::GrayImage(const uint8_t* pixels, int width, int height, int stride) : GrayImage(width, height) {
+
+    for(int y = 0; y < this->height; y++) {
+        std::copy(pixels + static_cast<size_t>(y) * stride, pixels + static_cast<size_t>(y) * stride + this->width, row(y));
+    }
+}
+
+int GrayImage::getWidth() const {
+    return this->width;
+}
+
+int GrayImage::getHeight() const {
+    return this->height;
+}
+
+uint8_t* GrayImage::row(int y) {
+    return this->pixels.data() + static_cast<size_t>(y) * this->width;
+}
+
+const uint8_t* GrayImage::row(int y) const {
+    return this->pixels.data() + static_cast<size_t>(y) * this->width;
+}
+
+// Resized copy. Every target pixel is the average of the source pixels it
+// covers, so thin lines and fine texture survive the downscale; enlarging
+// repeats pixels. Source rows are summed a band at a time into per column
+// totals, a loop the compiler vectorizes.
+GrayImage GrayImage::scaled(int width, int height) const {
+
+    GrayImage target(width, height);
+
+    if(this->width == 0 || this->height == 0) {
+        return target;
+    }
+
+    std::vector<int> left(target.width), right(target.width);
+    for(int x = 0; x < target.width; x++) {
+        left[x] = static_cast<int64_t>(x) * this->width / target.width;
+        right[x] = std::max(left[x] + 1, static_cast<int>(static_cast<int64_t>(x + 1) * this->width / target.width));
+    }
+
+    std::vector<uint32_t> sums(this->width);
+
+    for(int y = 0; y < target.height; y++) {
+
+        const int top = static_cast<int64_t>(y) * this->height / target.height;
+        const int bottom = std::max(top + 1, static_cast<int>(static_cast<int64_t>(y + 1) * this->height / target.height));
+
+        std::fill(sums.begin(), sums.end(), 0);
+        for(int sy = top; sy < bottom; sy++) {
+            const uint8_t* __restrict__ source = row(sy);
+            uint32_t* __restrict__ sum = sums.data();
+            for(int sx = 0; sx < this->width; sx++) {
+                sum[sx] += source[sx];
+            }
+        }
+
+        uint8_t* out = target.row(y);
+        for(int x = 0; x < target.width; x++) {
+            uint32_t total = 0;
+            for(int sx = left[x]; sx < right[x]; sx++) {
+                total += sums[sx];
+            }
+            const uint32_t count = (right[x] - left[x]) * (bottom - top);
+            out[x] = (total + count / 2) / count;
+        }
+    }
+    return target;
+}
+
+// One bit per pixel image of the same size, at most 64 rows are kept
+Bitmap GrayImage::dither(DitherMode mode) const {
+
+    // 8x8 Bayer matrix scaled to gray levels, entry n of 64 is n * 4 + 2
+    static const uint8_t bayer[8][8] = {
+        {  2, 130,  34, 162,  10, 138,  42, 170},
+        {194,  66, 226,  98, 202,  74, 234, 106},
+        { 50, 178,  18, 146,  58, 186,  26, 154},
+        {242, 114, 210,  82, 250, 122, 218,  90},
+        { 14, 142,  46, 174,   6, 134,  38, 166},
+        {206,  78, 238, 110, 198,  70, 230, 102},
+        { 62, 190,  30, 158,  54, 182,  22, 150},
+        {254, 126, 222,  94, 246, 118, 214,  86}
+    };
+
+    switch(mode) {
+        case DITHER_BAYER:
+            return ditherThreshold(bayer);
+        case DITHER_FLOYD_STEINBERG:
+            return ditherFloydSteinberg();
+        default:
+            return ditherThreshold(nullptr);
+    }
+}
+
+// Scales the image to width x height and dithers it
+Bitmap GrayImage::toBitmap(int width, int height, DitherMode mode) const {
+
+    if(width == this->width && height == this->height) {
+        return dither(mode);
+    }
+    return scaled(width, height).dither(mode);
+}
+
+// Pixels above the threshold tiled from the 8x8 table are on, without a
+// table the threshold is mid gray everywhere. Each row is compared against
+// a row of thresholds into one bit of a byte per column, and every 8 rows
+// the bytes go into the column words. Both are branch free loops over the
+// width on byte lanes, which the compiler vectorizes.
+Bitmap GrayImage::ditherThreshold(const uint8_t thresholds[8][8]) const {
+
+    const int rows = std::min(this->height, 64);
+    std::vector<uint64_t> columns(this->width, 0);
+    std::vector<uint8_t> tiled(this->width);
+    std::vector<uint8_t> bytes(this->width, 0);
+
+    for(int y = 0; y < rows; y++) {
+
+        for(int x = 0; x < this->width; x++) {
+            tiled[x] = thresholds ? thresholds[y & 7][x & 7] : 127;
+        }
+
+        const uint8_t* __restrict__ source = row(y);
+        const uint8_t* __restrict__ threshold = tiled.data();
+        uint8_t* __restrict__ byte = bytes.data();
+        const int shift = y & 7;
+
+        for(int x = 0; x < this->width; x++) {
+            byte[x] |= static_cast<uint8_t>((source[x] > threshold[x]) << shift);
+        }
+
+        if(shift == 7 || y == rows - 1) {
+            uint64_t* __restrict__ column = columns.data();
+            for(int x = 0; x < this->width; x++) {
+                column[x] |= static_cast<uint64_t>(byte[x]) << (y - shift);
+                byte[x] = 0;
+            }
+        }
+    }
+    return Bitmap(columns.data(), this->width, rows);
+}
+
+// Floyd-Steinberg error diffusion. Rows are scanned in alternating
+// directions so the error does not pile up into diagonal streaks, the
+// error of the current and next row is kept in two buffers with a spare
+// entry on each side.
+Bitmap GrayImage::ditherFloydSteinberg() const {
+
+    const int rows = std::min(this->height, 64);
+    std::vector<uint64_t> columns(this->width, 0);
+    std::vector<int> current(this->width + 2, 0);
+    std::vector<int> next(this->width + 2, 0);
+
+    for(int y = 0; y < rows; y++) {
+
+        const uint8_t* source = row(y);
+        const bool reverse = y & 1;
+        const int step = reverse ? -1 : 1;
+        std::fill(next.begin(), next.end(), 0);
+
+        for(int i = 0; i < this->width; i++) {
+
+            const int x = reverse ? this->width - 1 - i : i;
+            const int level = source[x] + current[x + 1] / 16;
+            const int value = (level > 127) ? 255 : 0;
+            const int error = level - value;
+
+            if(value) {
+                columns[x] |= 1ULL << y;
+            }
+            current[x + 1 + step] += error * 7;
+            next[x + 1 - step] += error * 3;
+            next[x + 1] += error * 5;
+            next[x + 1 + step] += error;
+        }
+        std::swap(current, next);
+    }
+    return Bitmap(columns.data(), this->width, rows);
+}
@@ -0,0 +1,172 @@
+/*
+    SSD1306_pnm.cpp
+
+*/
+#include "SSD1306_pnm.h"
+
+// Image in a caller owned buffer that has to outlive the object
+PnmImage::PnmImage(const uint8_t* data, size_t size) : data(data), size(size), mapped(0),
+    bitmap(false), width(0), height(0), maxValue(0), pixelsOffset(0), rowBytes(0) {
+    parse();
+}
+
+// Image file mapped read only, the pages are read in as rows are used
+PnmImage::PnmImage(const std::string& path) : data(nullptr), size(0), mapped(0),
+    bitmap(false), width(0), height(0), maxValue(0), pixelsOffset(0), rowBytes(0) {
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        std::cerr << "Failed to open image " << path << ": " << strerror(errno) << std::endl;
+        return;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(map != MAP_FAILED) {
+            this->data = static_cast<const uint8_t*>(map);
+            this->size = info.st_size;
+            this->mapped = info.st_size;
+        }
+        else {
+            std::cerr << "Failed to map image " << path << ": " << strerror(errno) << std::endl;
+        }
+    }
+    close(fd);
+
+    if(this->data) {
+        parse();
+    }
+}
+
+PnmImage::~PnmImage() {
+    if(this->mapped) {
+        munmap(const_cast<uint8_t*>(this->data), this->mapped);
+    }
+}
+
+bool PnmImage::isValid() const {
+    return this->rowBytes > 0;
+}
+
+// P4 image, one bit per pixel
+bool PnmImage::isBitmap() const {
+    return this->bitmap;
+}
+
+int PnmImage::getWidth() const {
+    return this->width;
+}
+
+int PnmImage::getHeight() const {
+    return this->height;
+}
+
+// Reads the header: magic number, width, height and for P5 the maximum gray
+// value, separated by whitespace and comments, then one whitespace byte
+// before the pixels. A malformed or truncated file leaves the image invalid.
+void PnmImage::parse() {
+
+    size_t pos = 0;
+
+    auto skipSpace = [&]() {
+        while(pos < this->size) {
+            if(this->data[pos] == '#') {
+                while(pos < this->size && this->data[pos] != '\n') pos++;
+            }
+            else if(isspace(this->data[pos])) {
+                pos++;
+            }
+            else {
+                break;
+            }
+        }
+    };
+    auto number = [&]() {
+        skipSpace();
+        long value = -1;
+        while(pos < this->size && isdigit(this->data[pos]) && value < 65536) {
+            value = ((value < 0) ? 0 : value * 10) + (this->data[pos++] - '0');
+        }
+        return static_cast<int>(value);
+    };
+
+    if(this->size < 2 || this->data[0] != 'P' || (this->data[1] != '4' && this->data[1] != '5')) {
+        std::cerr << "Not a binary PBM or PGM image" << std::endl;
+        return;
+    }
+    pos = 2;
+    this->bitmap = this->data[1] == '4';
+    this->width = number();
+    this->height = number();
+    this->maxValue = this->bitmap ? 1 : number();
+
+    if(this->width <= 0 || this->height <= 0 || this->width > PNM_MAX_SIZE || this->height > PNM_MAX_SIZE
+        || this->maxValue <= 0 || this->maxValue > 65535
+        || pos >= this->size || !isspace(this->data[pos])) {
+        std::cerr << "Invalid PNM header" << std::endl;
+        return;
+    }
+    this->pixelsOffset = pos + 1;
+
+    const size_t bytes = this->bitmap ? (this->width + 7) / 8 : static_cast<size_t>(this->width) * ((this->maxValue > 255) ? 2 : 1);
+    // Compared by division, the product of the header values can wrap a 32 bit size_t
+    if(static_cast<size_t>(this->height) > (this->size - this->pixelsOffset) / bytes) {
+        std::cerr << "PNM image is truncated" << std::endl;
+        return;
+    }
+    this->rowBytes = bytes;
+}
+
+const uint8_t* PnmImage::row(int y) const {
+    return this->data + this->pixelsOffset + this->rowBytes * y;
+}
+
+// Column words of the rectangle (sx, sy, width, height) with bit 0 in the top
+// row, clipped to the image and to 64 rows. PBM bits are copied as they are,
+// 1 is black and stays off. PGM rows are scaled to 8 bits and dithered as a
+// GrayImage of just the rectangle.
+void PnmImage::readColumns(int sx, int sy, int width, int height, uint64_t* columns, DitherMode mode) const {
+
+    std::fill(columns, columns + std::max(width, 0), 0);
+
+    const int x0 = std::max(sx, 0);
+    const int y0 = std::max(sy, 0);
+    const int x1 = std::min(sx + width, this->width);
+    const int y1 = std::min(sy + std::min(height, 64), this->height);
+
+    if(!isValid() || x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    if(this->bitmap) {
+        for(int y = y0; y < y1; y++) {
+            const uint8_t* pixels = row(y);
+            const int shift = y - sy;
+            for(int x = x0; x < x1; x++) {
+                const uint64_t black = (pixels[x >> 3] >> (7 - (x & 7))) & 1;
+                columns[x - sx] |= (black ^ 1) << shift;
+            }
+        }
+        return;
+    }
+
+    GrayImage region(x1 - x0, y1 - y0);
+    for(int y = y0; y < y1; y++) {
+        const uint8_t* pixels = row(y);
+        uint8_t* gray = region.row(y - y0);
+        if(this->maxValue == 255) {
+            std::copy(pixels + x0, pixels + x1, gray);
+            continue;
+        }
+        for(int x = x0; x < x1; x++) {
+            const int value = (this->maxValue > 255) ? (pixels[2 * x] << 8) | pixels[2 * x + 1] : pixels[x];
+            gray[x - x0] = std::min(value, this->maxValue) * 255 / this->maxValue;
+        }
+    }
+
+    const Bitmap bits = region.dither(mode);
+    for(int x = x0; x < x1; x++) {
+        columns[x - sx] = bits.column(x - x0) << (y0 - sy);
+    }
+}
@@ -0,0 +1,62 @@
+/*
+    SSD1306_sprite.cpp
+
+*/
+#include "SSD1306_sprite.h"
+
+Sprite::Sprite(const Bitmap& bitmap, RasterOp op) : bitmap(bitmap), op(op),
+    shifts(SPRITE_MAX_Y - SPRITE_MIN_Y + 1), x(0), y(0), visible(false) {
+}
+
+// Bitmap columns moved to row offset y, y has to be within SPRITE_MIN_Y - SPRITE_MAX_Y
+const uint64_t* Sprite::columns(int y) {
+
+    std::vector<uint64_t>& shifted = this->shifts[y - SPRITE_MIN_Y];
+
+    if(shifted.empty() && this->bitmap.getWidth() > 0) {
+        shifted.resize(this->bitmap.getWidth());
+        for(int col = 0; col < this->bitmap.getWidth(); col++) {
+            const uint64_t rows = this->bitmap.column(col);
+            shifted[col] = (y >= 0) ? rows << y : rows >> -y;
+        }
+    }
+    return shifted.data();
+}
+
+// Rows covered by the sprite at row offset y
+uint64_t Sprite::mask(int y) const {
+    return (y >= 0) ? this->bitmap.rowsMask() << y : this->bitmap.rowsMask() >> -y;
+}
+
+int Sprite::getWidth() const {
+    return this->bitmap.getWidth();
+}
+
+int Sprite::getHeight() const {
+    return this->bitmap.getHeight();
+}
+
+RasterOp Sprite::getOp() const {
+    return this->op;
+}
+
+void Sprite::setPosition(int x, int y) {
+    this->x = x;
+    this->y = y;
+}
+
+int Sprite::getX() const {
+    return this->x;
+}
+
+int Sprite::getY() const {
+    return this->y;
+}
+
+void Sprite::setVisible(bool is_visible) {
+    this->visible = is_visible;
+}
+
+bool Sprite::isVisible() const {
+    return this->visible;
+}
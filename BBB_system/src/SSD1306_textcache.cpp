@@ -0,0 +1,127 @@
+/*
+    SSD1306_textcache.cpp
+
+*/
+#include "SSD1306_textcache.h"
+
+TextCache::TextCache(size_t capacity) : slots(std::max<size_t>(capacity, 1), Slot{0, 0, 0}),
+    texts(slots.size()), runs(slots.size()), clock(0), stats() {
+}
+
+// The run of the text in the font, rendered and cached on a miss. The
+// reference stays valid until the run is evicted, which takes at least
+// capacity lookups of other texts.
+const TextRun& TextCache::run(const Font& font, const std::string& text) {
+
+    const uint32_t key = hash(text);
+    const uint32_t revision = font.getRevision();
+
+    // Restart the clock before it wraps, the order of the slots is kept
+    if(++this->clock == 0) {
+        for(Slot& slot : this->slots) {
+            slot.used = (slot.used > 0x80000000u) ? slot.used - 0x80000000u : 0;
+        }
+        this->clock = 0x80000000u;
+    }
+
+    size_t oldest = 0;
+    for(size_t i = 0; i < this->slots.size(); i++) {
+        Slot& slot = this->slots[i];
+
+        if(slot.hash == key && slot.revision == revision && this->texts[i] == text) {
+            slot.used = this->clock;
+            this->stats.hits++;
+            return this->runs[i];
+        }
+        if(slot.used < this->slots[oldest].used) {
+            oldest = i;
+        }
+    }
+    this->stats.misses++;
+
+    // The least recently used slot is reused, its text and columns keep their capacity
+    Slot& slot = this->slots[oldest];
+    if(slot.revision != 0) {
+        this->stats.evictions++;
+    }
+    slot.hash = key;
+    slot.revision = revision;
+    slot.used = this->clock;
+    this->texts[oldest].assign(text);
+    render(font, text, this->runs[oldest]);
+    return this->runs[oldest];
+}
+
+void TextCache::clear() {
+    std::fill(this->slots.begin(), this->slots.end(), Slot{0, 0, 0});
+}
+
+// Runs in the cache
+size_t TextCache::size() const {
+    return std::count_if(this->slots.begin(), this->slots.end(), [](const Slot& slot) { return slot.revision != 0; });
+}
+
+// Runs the cache holds at most
+size_t TextCache::getCapacity() const {
+    return this->slots.size();
+}
+
+TextCacheStats TextCache::getStats() const {
+    return this->stats;
+}
+
+// FNV-1a of the text bytes
+uint32_t TextCache::hash(const std::string& text) {
+
+    uint32_t value = 2166136261u;
+    for(const char c : text) {
+        value = (value ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return value;
+}
+
+// Walks the pen over the text like Canvas::drawText() does and ORs every
+// glyph into one column array covering all of the ink
+void TextCache::render(const Font& font, const std::string& text, TextRun& run) {
+
+    int left = 0, right = 0;
+    int pen = 0;
+    uint32_t previous = 0;
+
+    // First pass for the extent of the ink, glyphs may reach past the pen on either side
+    for(size_t i = 0; i < text.size(); ) {
+        const size_t start = i;
+        const uint32_t code = nextCodePoint(text, i);
+        if(start > 0) {
+            pen += font.kerning(previous, code);
+        }
+        const FontGlyph& glyph = font.glyph(code);
+        if(glyph.width > 0) {
+            left = std::min(left, pen + glyph.left);
+            right = std::max(right, pen + glyph.left + glyph.width);
+        }
+        pen += glyph.advance;
+        previous = code;
+    }
+
+    run.left = left;
+    run.advance = pen;
+    run.height = font.getHeight();
+    run.columns.assign(right - left, 0);
+
+    pen = 0;
+    for(size_t i = 0; i < text.size(); ) {
+        const size_t start = i;
+        const uint32_t code = nextCodePoint(text, i);
+        if(start > 0) {
+            pen += font.kerning(previous, code);
+        }
+        const FontGlyph& glyph = font.glyph(code);
+        const uint64_t* columns = font.columns(glyph);
+        for(int col = 0; col < glyph.width; col++) {
+            run.columns[pen + glyph.left + col - left] |= columns[col];
+        }
+        pen += glyph.advance;
+        previous = code;
+    }
+}
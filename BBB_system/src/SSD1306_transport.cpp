@@ -0,0 +1,289 @@
+/*
+    SSD1306_transport.cpp
+
+*/
+#include "SSD1306_transport.h"
+
+Transport::Transport() : stats{0, 0, 0, 0} {
+    this->queue.reserve(I2C_RDWR_IOCTL_MAX_MSGS);
+    this->arena.reserve(2048);
+}
+
+Transport::~Transport() {
+}
+
+// Appends a message with the given control byte to the arena and returns its payload
+uint8_t* Transport::queueOwned(uint8_t control, size_t len) {
+
+    size_t offset = this->arena.size();
+    this->arena.resize(offset + len + 1);
+    this->arena[offset] = control;
+    this->queue.push_back({nullptr, offset, len + 1});
+    return &this->arena[offset + 1];
+}
+
+// Queue a command message, the commands are copied
+void Transport::queueCommand(const uint8_t* commands, size_t len) {
+    std::memcpy(queueOwned(CTRL_COMMAND, len), commands, len);
+}
+
+// Queue a data message, the data is copied
+void Transport::queueData(const uint8_t* data, size_t len) {
+    std::memcpy(queueOwned(CTRL_DATA, len), data, len);
+}
+
+// Queue a data message and return its payload for the caller to fill.
+// The pointer is valid until the next queue call.
+uint8_t* Transport::reserveData(size_t len) {
+    return queueOwned(CTRL_DATA, len);
+}
+
+// Queue a message that already starts with its control byte. The buffer is
+// not copied and has to stay untouched until flush() returns.
+void Transport::queueMessage(const uint8_t* message, size_t len) {
+    this->queue.push_back({message, 0, len});
+}
+
+const uint8_t* Transport::messageBuffer(const Message& msg) const {
+    return msg.external ? msg.external : &this->arena[msg.offset];
+}
+
+// Submit all queued messages. Returns the number of message bytes sent or -errno on failure.
+int Transport::flush() {
+
+    if(this->queue.empty()) {
+        return 0;
+    }
+
+    int bytes = 0;
+    for(const Message& msg : this->queue) {
+        bytes += msg.len;
+    }
+
+    int status = submit(this->queue);
+
+    this->stats.flushes++;
+    if(status < 0) {
+        this->stats.errors++;
+    }
+    else {
+        this->stats.transactions += this->queue.size();
+        this->stats.bytes += bytes;
+    }
+
+    discard();
+    return (status < 0) ? status : bytes;
+}
+
+// Drop all queued messages without sending them
+void Transport::discard() {
+    this->queue.clear();
+    this->arena.clear();
+}
+
+// Sends a single NOP command outside of the queue, returns 0 when the
+// display acknowledged it or -errno
+int Transport::probe() {
+
+    static const uint8_t nop[] = {CTRL_COMMAND, CMD_NOP};
+    const std::vector<Message> messages = {{nop, 0, sizeof(nop)}};
+
+    return submit(messages);
+}
+
+size_t Transport::pending() const {
+    return this->queue.size();
+}
+
+const TransportStats& Transport::getStats() const {
+    return this->stats;
+}
+
+void Transport::resetStats() {
+    this->stats = {0, 0, 0, 0};
+}
+
+I2CTransport::I2CTransport(const int bus, const uint8_t address) : bus(bus), address(address), file(-1) {}
+
+I2CTransport::~I2CTransport() {
+    close();
+}
+
+// Open the device file of the i2c bus and check that combined transfers are supported
+bool I2CTransport::open() {
+
+    char file_path[20];
+    snprintf(file_path, 19, "/dev/i2c-%d", this->bus);
+    this->file = ::open(file_path, O_RDWR);
+
+    if(this->file < 0) {
+        std::cerr << "Failed to open the i2c bus" << std::endl;
+        return false;
+    }
+
+    unsigned long funcs = 0;
+    if(ioctl(this->file, I2C_FUNCS, &funcs) < 0 || !(funcs & I2C_FUNC_I2C)) {
+        std::cerr << "/dev/i2c-" << this->bus << " does not support I2C_RDWR transfers" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void I2CTransport::close() {
+    if(this->file >= 0) {
+        ::close(this->file);
+        this->file = -1;
+    }
+    discard();
+}
+
+bool I2CTransport::isOpen() const {
+    return this->file >= 0;
+}
+
+// Every message becomes one i2c_msg, at most I2C_RDWR_IOCTL_MAX_MSGS per ioctl
+int I2CTransport::submit(const std::vector<Message>& messages) {
+
+    if(this->file < 0) {
+        return -EBADF;
+    }
+
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    size_t index = 0;
+
+    while(index < messages.size()) {
+
+        size_t count = std::min(messages.size() - index, static_cast<size_t>(I2C_RDWR_IOCTL_MAX_MSGS));
+
+        for(size_t i = 0; i < count; i++) {
+            const Message& msg = messages[index + i];
+            msgs[i].addr = this->address;
+            msgs[i].flags = 0;
+            msgs[i].len = static_cast<__u16>(msg.len);
+            msgs[i].buf = const_cast<uint8_t*>(messageBuffer(msg));
+        }
+
+        struct i2c_rdwr_ioctl_data batch = { msgs, static_cast<__u32>(count) };
+
+        if(ioctl(this->file, I2C_RDWR, &batch) != static_cast<int>(count)) {
+            return -errno;
+        }
+        index += count;
+    }
+    return 0;
+}
+
+SPITransport::SPITransport(const int bus, const int chipSelect, const int dcPin, const uint32_t speed) :
+    bus(bus), chipSelect(chipSelect), dcPin(dcPin), speed(speed), file(-1), dcFile(-1), dcState(-1) {}
+
+SPITransport::~SPITransport() {
+    close();
+}
+
+// Open spidev and the D/C gpio, the gpio has to be exported as an output
+bool SPITransport::open() {
+
+    char file_path[32];
+    snprintf(file_path, 31, "/dev/spidev%d.%d", this->bus, this->chipSelect);
+    this->file = ::open(file_path, O_RDWR);
+
+    if(this->file < 0) {
+        std::cerr << "Failed to open " << file_path << std::endl;
+        return false;
+    }
+
+    uint8_t mode = SPI_MODE_0;
+    uint8_t bits = 8;
+    if(ioctl(this->file, SPI_IOC_WR_MODE, &mode) < 0 ||
+       ioctl(this->file, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+       ioctl(this->file, SPI_IOC_WR_MAX_SPEED_HZ, &this->speed) < 0) {
+        std::cerr << "Failed to configure " << file_path << std::endl;
+        close();
+        return false;
+    }
+
+    std::string dc_path = "/sys/class/gpio/gpio" + std::to_string(this->dcPin) + "/value";
+    this->dcFile = ::open(dc_path.c_str(), O_WRONLY);
+
+    if(this->dcFile < 0) {
+        std::cerr << "Failed to open GPIO" << this->dcPin << " device file" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SPITransport::close() {
+    if(this->file >= 0) {
+        ::close(this->file);
+        this->file = -1;
+    }
+    if(this->dcFile >= 0) {
+        ::close(this->dcFile);
+        this->dcFile = -1;
+    }
+    this->dcState = -1;
+    discard();
+}
+
+bool SPITransport::isOpen() const {
+    return this->file >= 0 && this->dcFile >= 0;
+}
+
+bool SPITransport::setDataMode(bool is_data) {
+
+    if(this->dcState == static_cast<int>(is_data)) {
+        return true;
+    }
+    const char level = is_data ? '1' : '0';
+    if(pwrite(this->dcFile, &level, 1, 0) != 1) {
+        return false;
+    }
+    this->dcState = is_data;
+    return true;
+}
+
+// Runs of command or data messages go out as one SPI_IOC_MESSAGE each, the
+// control byte only selects the D/C level and is not clocked out
+int SPITransport::submit(const std::vector<Message>& messages) {
+
+    if(!isOpen()) {
+        return -EBADF;
+    }
+
+    const size_t max_transfers = 32;
+    struct spi_ioc_transfer transfers[max_transfers];
+    size_t index = 0;
+
+    while(index < messages.size()) {
+
+        bool is_data = messageBuffer(messages[index])[0] & CTRL_DATA;
+        size_t count = 0;
+
+        std::memset(transfers, 0, sizeof(transfers));
+
+        while(index + count < messages.size() && count < max_transfers) {
+            const Message& msg = messages[index + count];
+            const uint8_t* buf = messageBuffer(msg);
+
+            if(static_cast<bool>(buf[0] & CTRL_DATA) != is_data) {
+                break;
+            }
+            transfers[count].tx_buf = reinterpret_cast<unsigned long>(buf + 1);
+            transfers[count].len = msg.len - 1;
+            transfers[count].speed_hz = this->speed;
+            transfers[count].bits_per_word = 8;
+            count++;
+        }
+
+        if(!setDataMode(is_data)) {
+            return -errno;
+        }
+        if(ioctl(this->file, SPI_IOC_MESSAGE(count), transfers) < 0) {
+            return -errno;
+        }
+        index += count;
+    }
+    return 0;
+}
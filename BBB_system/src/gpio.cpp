@@ -36,6 +36,8 @@ int main() {
     int analog_control = 0;
     int analog_temp = 0;
     bool startup = true;
+    bool redraw = true;
+    int ticks = 0;
     bool rightBtn_press = false;
     bool leftBtn_press = false;
 
@@ -50,18 +52,29 @@ int main() {
 
             if(analog_temp - analog_control >= 2) {
                 system.getMain_menu().scrollUp();
+                redraw = true;
             } else if(analog_control - analog_temp >= 2 ) {
                 system.getMain_menu().scrollDown();
+                redraw = true;
             }
         }
 
-        system.getMain_menu().updateMenu(5, 20);
-
         analog_temp = analog_control;
 
         startup = false;
 
-        system.updateState();
+        // The whole frame when the menu changed and about once a second for the
+        // connection icon, otherwise only the clock and the gauge go out
+        if(redraw || ++ticks % 40 == 0) {
+            system.getOLED().getDisplay()->clearBuffer();
+            system.getMain_menu().updateMenu(5, 20);
+            system.updateState();
+            redraw = false;
+        }
+        else {
+            system.updateClock();
+            system.updateGauge();
+        }
 
 
 
@@ -79,6 +92,7 @@ int main() {
                     leftBtn_press = false;
 
                     system.checkMessages();
+                    redraw = true;
                     break;
                 case 1:
 